@@ -0,0 +1,99 @@
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class Benchmark
+ * @brief Headless rendering benchmark (`--bench`).
+ *
+ * Drives a fixed number of frames with a scripted camera path and button
+ * presses, applied by the simulation thread, so every run renders the same
+ * scene. Each frame is timed from its start until glFinish() returns, which
+ * includes the GPU (or software rasterizer) work. At the end the frame-time percentiles are reported and
+ * the last frame can be written to a PNG for regression comparison.
+ *
+ * No display server is needed: GLFW's null platform renders through OSMesa,
+ * or through a surfaceless EGL context (HeadlessContext) when OSMesa is
+ * missing. Only if neither works is a hidden window on a display used.
+ */
+class Benchmark {
+public:
+    /**
+     * @brief Prepares a run.
+     * @param frames Number of frames to render.
+     * @param pngPath PNG file for the last frame, empty to skip.
+     */
+    Benchmark(int frames, std::string pngPath);
+
+    /**
+     * @brief Starts timing a frame.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Waits for the frame's GL work to finish and records its time.
+     */
+    void EndFrame();
+
+    /**
+     * @brief Scripted camera for a simulation tick.
+     *
+     * The benchmark runs the simulation in lockstep with rendering, so tick n
+     * is shown by frame n. Safe to call from the simulation thread.
+     * @param tick Simulation tick.
+     * @param yaw Receives the yaw angle in degrees.
+     * @param pitch Receives the pitch angle in degrees.
+     * @param radius Receives the camera distance.
+     */
+    static void Camera(long tick, float& yaw, float& pitch, float& radius);
+
+    /**
+     * @brief Scripted button press for a simulation tick.
+     * @param tick Simulation tick.
+     * @return Button label, or nullptr if nothing is pressed on this tick.
+     */
+    static const char* Input(long tick);
+
+    /**
+     * @brief Reads the back buffer and writes it to the PNG file, if one was given.
+     * @param width Framebuffer width.
+     * @param height Framebuffer height.
+     * @return false if writing failed.
+     */
+    bool SaveFrame(int width, int height) const;
+
+    /**
+     * @brief Prints frame count, mean and frame-time percentiles.
+     * @param out Output stream.
+     */
+    void Report(std::ostream& out) const;
+
+    bool LastFrame() const { return frame == frames - 1; }  ///< the current frame is the final one
+    bool Done() const { return frame >= frames; }           ///< all frames rendered
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int frames;
+    int frame = 0;
+    std::string pngPath;
+    Clock::time_point frameStart;
+    std::vector<float> frameTimes;  ///< milliseconds per frame
+};
+
+/**
+ * @brief Writes 8-bit RGBA pixels to an uncompressed PNG file.
+ * @param path Output file.
+ * @param width Image width.
+ * @param height Image height.
+ * @param rgba Pixels, top row first, width * height * 4 bytes.
+ * @return false if the file could not be written.
+ */
+bool WritePng(const std::string& path, int width, int height, const unsigned char* rgba);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Directory for on-disk caches.
+ *
+ * $<envVar> when set, otherwise $XDG_CACHE_HOME/ivs_calculator or
+ * ~/.cache/ivs_calculator; <envVar>=off disables the cache.
+ * @param envVar Variable overriding the directory, e.g. "CALC_MESH_CACHE".
+ * @return Directory, empty if caching is disabled or no home is known.
+ */
+std::string CacheDir(const char* envVar);
+
+/**
+ * @brief FNV-1a hash of a file's contents.
+ * @param path File to hash.
+ * @param hash Hash to continue, for keys built from several files.
+ * @return Hash, or 0 if the file cannot be read.
+ */
+uint64_t HashFile(const std::string& path, uint64_t hash = 14695981039346656037ull);
+
+#endif // FILE_CACHE_H
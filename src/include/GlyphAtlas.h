@@ -0,0 +1,115 @@
+#pragma once
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <vector>
+
+/**
+ * @struct AtlasRect
+ * @brief Pixel rectangle inside the atlas.
+ */
+struct AtlasRect {
+    int x = 0;  ///< left edge in pixels
+    int y = 0;  ///< top edge in pixels
+    int w = 0;  ///< width in pixels
+    int h = 0;  ///< height in pixels
+    int shelf = -1;  ///< shelf the rect was packed into
+};
+
+/**
+ * @class GlyphAtlas
+ * @brief Single-channel texture atlas with a shelf packer.
+ *
+ * Glyph bitmaps are placed left to right on horizontal shelves. A glyph
+ * goes to the shelf that fits it with the least wasted height, or opens a
+ * new shelf below the last one. Whole shelves can be emptied again, which
+ * lets a cache evict its least recently used glyphs. The atlas only manages
+ * CPU pixels, uploading them is left to the caller.
+ */
+class GlyphAtlas {
+public:
+    /**
+     * @brief Creates an empty atlas.
+     * @param width Atlas width in pixels.
+     * @param height Atlas height in pixels.
+     * @param padding Empty pixels kept around every glyph (avoids filtering bleed).
+     */
+    GlyphAtlas(int width, int height, int padding = 1);
+
+    /**
+     * @brief Reserves space for a bitmap.
+     * @param w Bitmap width.
+     * @param h Bitmap height.
+     * @param rect Receives the reserved rectangle (without padding).
+     * @return false if the atlas has no room left.
+     */
+    bool Pack(int w, int h, AtlasRect& rect);
+
+    /**
+     * @brief Copies a bitmap into a reserved rectangle.
+     * @param rect Rectangle returned by Pack().
+     * @param src Source pixels, one byte per pixel.
+     * @param pitch Bytes per source row.
+     */
+    void Blit(const AtlasRect& rect, const unsigned char* src, int pitch);
+
+    /**
+     * @brief Removes all glyphs and clears the pixels.
+     */
+    void Clear();
+
+    /**
+     * @brief Empties one shelf so Pack() can reuse it; its height stays the same.
+     * @param shelf Shelf index from AtlasRect::shelf.
+     */
+    void ClearShelf(int shelf);
+
+    /**
+     * @brief Checks whether an empty shelf could hold a bitmap.
+     * @param shelf Shelf index.
+     * @param w Bitmap width.
+     * @param h Bitmap height.
+     * @return true if the bitmap fits once the shelf is cleared.
+     */
+    bool ShelfFits(int shelf, int w, int h) const;
+
+    /**
+     * @brief Full-width rectangle covered by a shelf, e.g. to re-upload it.
+     * @param shelf Shelf index.
+     */
+    AtlasRect ShelfBounds(int shelf) const;
+
+    int ShelfCount() const { return static_cast<int>(shelves.size()); }  ///< shelves opened so far
+
+    int Width() const { return width; }      ///< atlas width in pixels
+    int Height() const { return height; }    ///< atlas height in pixels
+    const unsigned char* Pixels() const { return pixels.data(); }  ///< row-major R8 pixels
+
+    /**
+     * @brief One horizontal row of glyphs.
+     */
+    struct Shelf {
+        int y;       ///< top of the shelf
+        int height;  ///< shelf height including padding
+        int x;       ///< next free x position
+    };
+
+    const std::vector<Shelf>& Shelves() const { return shelves; }  ///< packer state, for caching
+    int NextShelfY() const { return nextShelfY; }                  ///< top of the unused area
+
+    /**
+     * @brief Restores a previously cached atlas.
+     * @param savedShelves Shelves from Shelves().
+     * @param savedNextShelfY Value from NextShelfY().
+     * @param savedPixels Width() * Height() pixels from Pixels().
+     */
+    void Restore(const Shelf* savedShelves, int shelfCount, int savedNextShelfY, const unsigned char* savedPixels);
+
+private:
+    int width, height, padding;
+    int nextShelfY = 0;
+    std::vector<Shelf> shelves;
+    std::vector<unsigned char> pixels;
+};
+
+#endif // GLYPH_ATLAS_H
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <string>
+
+/**
+ * @class HeadlessContext
+ * @brief OpenGL context without a window or a display server, through EGL.
+ *
+ * Uses the surfaceless Mesa platform when available (GPU or llvmpipe, no
+ * X11/Wayland needed), otherwise the default EGL display. Rendering goes to
+ * a pbuffer, so the default framebuffer exists and can be read back.
+ * libEGL is loaded at run time: builds and windowed runs do not depend on it.
+ */
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    /**
+     * @brief Creates an OpenGL 3.3 compatibility context with a pbuffer and makes it current.
+     * @param width Pbuffer width.
+     * @param height Pbuffer height.
+     * @param error Receives the reason on failure, may be null.
+     * @return false if libEGL or a suitable display, config or context is missing.
+     */
+    bool Create(int width, int height, std::string* error = nullptr);
+
+    /**
+     * @brief Whether Create() succeeded.
+     */
+    bool Active() const { return context != nullptr; }
+
+    /**
+     * @brief Finishes the frame (pbuffers have nothing to present).
+     */
+    void SwapBuffers();
+
+    /**
+     * @brief GL function lookup for gladLoadGLLoader(), valid after Create().
+     */
+    static void* GetProcAddress(const char* name);
+
+private:
+    void Destroy();
+
+    void* library = nullptr;
+    void* display = nullptr;
+    void* surface = nullptr;
+    void* context = nullptr;
+};
+
+#endif // HEADLESS_CONTEXT_H
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Kind of a recorded input event.
+ */
+enum class InputEventType : uint8_t {
+    Tick,         ///< simulation tick the following events belong to: code = tick, x = dt
+    Key,          ///< key callback: code = key, action, mods
+    Char,         ///< character callback: code = codepoint
+    MouseButton,  ///< mouse button callback: code = button, action, mods
+    CursorPos,    ///< cursor position callback: x, y
+    Scroll,       ///< scroll callback: x, y offsets
+};
+
+/**
+ * @struct InputEvent
+ * @brief One recorded event, stored as is in the recording file (20 bytes).
+ */
+struct InputEvent {
+    float time = 0.0f;     ///< seconds since recording started
+    InputEventType type = InputEventType::Tick;
+    uint8_t action = 0;    ///< GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+    uint16_t mods = 0;     ///< GLFW modifier bits
+    int32_t code = 0;      ///< key, codepoint or mouse button
+    float x = 0.0f;        ///< cursor x, scroll x or tick dt
+    float y = 0.0f;        ///< cursor y or scroll y
+};
+
+/**
+ * @class InputRecorder
+ * @brief Records GLFW input to a binary file and plays it back.
+ *
+ * A recording is a header followed by the raw event array. Every simulation
+ * tick that received input writes a Tick event with its number, followed by
+ * the events it applied. Replay delivers the events to the same tick
+ * numbers, so camera easing and calculator state evolve exactly as in the
+ * recorded session.
+ */
+class InputRecorder {
+public:
+    enum class Mode { Off, Record, Replay };
+
+    InputRecorder() = default;
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /**
+     * @brief Starts recording into a file.
+     * @param path Output file, overwritten.
+     * @return false if the file could not be created.
+     */
+    bool StartRecording(const std::string& path);
+
+    /**
+     * @brief Loads a recording for replay.
+     * @param path Recording file.
+     * @return false if the file is missing or not a valid recording.
+     */
+    bool StartReplay(const std::string& path);
+
+    /**
+     * @brief Appends an event while recording, ignored otherwise.
+     * @param event Event to store.
+     */
+    void Add(const InputEvent& event);
+
+    /**
+     * @brief Advances replay to the next Tick event.
+     * @param event Receives the Tick event (tick number, time and dt).
+     * @return false when the recording is exhausted.
+     */
+    bool NextTick(InputEvent& event);
+
+    /**
+     * @brief Next input event of the current replay tick.
+     * @return The event, or nullptr once the next Tick event is reached.
+     */
+    const InputEvent* NextEvent();
+
+    Mode GetMode() const { return mode; }       ///< current mode
+    size_t TickCount() const { return ticks; }  ///< ticks with input recorded so far, or in the loaded replay
+
+private:
+    Mode mode = Mode::Off;
+    std::ofstream out;
+    std::vector<InputEvent> events;  ///< loaded replay
+    size_t cursor = 0;               ///< next replay event
+    size_t ticks = 0;
+};
+
+#endif // INPUT_RECORDER_H
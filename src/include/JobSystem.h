@@ -0,0 +1,133 @@
+#pragma once
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobSystem
+ * @brief Pool of worker threads running queued jobs in submission order.
+ *
+ * Jobs may submit further jobs. A job that throws is reported on stderr and
+ * dropped, it does not take the worker down with it.
+ */
+class JobSystem {
+public:
+    /**
+     * @brief Starts the workers.
+     * @param threads Worker count, 0 for LoadThreadCount().
+     */
+    explicit JobSystem(unsigned threads = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Queues a job (any thread). Ignored once the system is stopped.
+     */
+    void Submit(std::function<void()> job);
+
+    /**
+     * @brief Blocks until the queue is empty and no job is running.
+     */
+    void WaitIdle();
+
+    /**
+     * @brief Drops the jobs not started yet, waits for the running ones and joins the workers.
+     */
+    void Stop();
+
+    /**
+     * @brief Number of worker threads.
+     */
+    unsigned ThreadCount() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    void Work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+/**
+ * @class UploadQueue
+ * @brief Tasks handed from loader threads to the thread owning the GL context.
+ *
+ * The owner drains the queue once per frame under a time budget, so a burst
+ * of finished assets is spread over several frames instead of stalling one.
+ */
+class UploadQueue {
+public:
+    /**
+     * @brief Queues a task (any thread).
+     */
+    void Push(std::function<void()> task);
+
+    /**
+     * @brief Runs queued tasks in order until the budget is spent (owner thread).
+     *
+     * At least one task runs per call, so a task longer than the budget
+     * still makes progress. Exceptions propagate to the caller, the task
+     * that threw is dropped.
+     * @param budgetMs Time budget in milliseconds.
+     * @return Number of tasks run.
+     */
+    size_t Run(double budgetMs);
+
+    /**
+     * @brief Number of queued tasks (any thread).
+     */
+    size_t Pending();
+
+private:
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+};
+
+/**
+ * @class LoadProgress
+ * @brief Steps of a multi-part load, counted from any thread.
+ *
+ * Work announces its steps with Add() before completing any of its own
+ * steps, so the total never falls behind the completed count while more
+ * work is still to come.
+ */
+class LoadProgress {
+public:
+    void Add(unsigned steps = 1) { total += steps; }
+    void Complete(unsigned steps = 1) { done += steps; }
+    unsigned Done() const { return done; }
+    unsigned Total() const { return total; }
+
+    /**
+     * @brief Whether every announced step is complete.
+     */
+    bool Finished() const { return done >= total; }
+
+    /**
+     * @brief Completed share in [0, 1].
+     */
+    float Fraction() const {
+        unsigned all = total;
+        return all ? std::min(1.0f, static_cast<float>(done) / static_cast<float>(all)) : 1.0f;
+    }
+
+private:
+    std::atomic<unsigned> done = 0;
+    std::atomic<unsigned> total = 0;
+};
+
+#endif // JOB_SYSTEM_H
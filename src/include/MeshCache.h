@@ -0,0 +1,112 @@
+#pragma once
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MeshOptimizer.h"
+
+/**
+ * @struct MeshMaterial
+ * @brief Material table entry of a processed mesh (fixed size, stored as is).
+ */
+struct MeshMaterial {
+    char name[64] = {};      ///< material name from the .mtl file
+    char texture[192] = {};  ///< diffuse texture file, relative to the model folder
+    int32_t layer = -2;      ///< texture array layer, negative for special materials
+};
+
+/**
+ * @struct MeshRange
+ * @brief Index range of one part of a processed mesh.
+ */
+struct MeshRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t material = -1;   ///< index into the material table, -1 for none
+};
+
+/**
+ * @struct MeshLod
+ * @brief Index range drawing the whole mesh at one level of detail.
+ */
+struct MeshLod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;      ///< largest deviation from the full mesh, in model units
+};
+
+/**
+ * @struct MeshBuffers
+ * @brief Processed mesh ready for upload: pointers to the buffers and tables.
+ */
+struct MeshBuffers {
+    const PackedVertex* vertices = nullptr;
+    uint32_t vertexCount = 0;
+    const void* indices = nullptr;
+    uint32_t indexCount = 0;
+    uint32_t indexSize = 4;               ///< 2 or 4 bytes per index
+    const MeshRange* ranges = nullptr;    ///< parts of the full detail level
+    uint32_t rangeCount = 0;
+    const MeshLod* lods = nullptr;        ///< levels of detail, finest first
+    uint32_t lodCount = 0;
+    const MeshMaterial* materials = nullptr;
+    uint32_t materialCount = 0;
+};
+
+/**
+ * @class MeshCache
+ * @brief Binary cache of processed meshes, memory-mapped when loaded.
+ *
+ * A cache file is a header followed by the vertex buffer, the index buffer,
+ * the draw ranges, the levels of detail and the material table, in the exact layout the GPU and
+ * the loader use. Opening one maps the file and points the buffers straight
+ * into the mapping, so loading costs one mmap plus the upload itself. The
+ * header stores a hash of the source files, a stale cache is never used.
+ */
+class MeshCache {
+public:
+    MeshCache() = default;
+    ~MeshCache();
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    /**
+     * @brief Maps a cache file.
+     * @param path Cache file.
+     * @param sourceHash Hash of the source files the cache must have been built from.
+     * @return false if the file is missing, stale or malformed.
+     */
+    bool Open(const std::string& path, uint64_t sourceHash);
+
+    /**
+     * @brief Buffers of the opened file, valid while the cache is alive.
+     */
+    const MeshBuffers& Buffers() const { return buffers; }
+
+    /**
+     * @brief Writes a cache file (through a temporary file and a rename).
+     * @param path Cache file, its directory is created if needed.
+     * @param sourceHash Hash of the source files.
+     * @param buffers Processed mesh.
+     * @return false if the file could not be written.
+     */
+    static bool Write(const std::string& path, uint64_t sourceHash, const MeshBuffers& buffers);
+
+    /**
+     * @brief Cache file for a source hash.
+     *
+     * Lives in $CALC_MESH_CACHE, $XDG_CACHE_HOME/ivs_calculator or
+     * ~/.cache/ivs_calculator; CALC_MESH_CACHE=off disables caching.
+     * @return Path, empty if caching is disabled.
+     */
+    static std::string Path(uint64_t sourceHash);
+
+private:
+    void* mapping = nullptr;
+    size_t size = 0;
+    MeshBuffers buffers;
+};
+
+#endif // MESH_CACHE_H
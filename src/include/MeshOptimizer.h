@@ -0,0 +1,117 @@
+#pragma once
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct PackedVertex
+ * @brief Quantized model vertex as uploaded to the GPU (24 bytes).
+ *
+ * Position stays full precision, texture coordinates are half floats and
+ * the normal is signed normalized 10-10-10-2 (GL_INT_2_10_10_10_REV).
+ */
+struct PackedVertex {
+    float position[3];     ///< x, y, z
+    uint16_t texcoord[2];  ///< u, v as IEEE half floats
+    uint32_t normal;       ///< x, y, z in 10 bits each, w unused
+    int16_t layer;         ///< texture array layer, negative values are special materials
+    uint16_t padding = 0;
+};
+
+/**
+ * @brief Merges bit-identical vertices and rewrites the indices to match.
+ * @param vertices Vertex attributes, floatsPerVertex floats each, compacted in place.
+ * @param floatsPerVertex Floats per vertex.
+ * @param indices Indices into vertices, rewritten in place.
+ * @return Number of unique vertices left.
+ */
+size_t WeldVertices(std::vector<float>& vertices, size_t floatsPerVertex, std::vector<uint32_t>& indices);
+
+/**
+ * @brief Reorders triangles for the post-transform vertex cache.
+ *
+ * Tom Forsyth's linear-speed greedy algorithm: the next triangle is the one
+ * whose vertices score highest for being recently used in a simulated LRU
+ * cache and for having few triangles left. Only the order of the triangles
+ * in the range changes, so ranges of a larger index buffer can be
+ * optimized one at a time.
+ * @param indices Triangle list to reorder in place.
+ * @param indexCount Number of indices, a multiple of 3.
+ * @param vertexCount Number of vertices the indices refer to.
+ */
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * @brief Renumbers vertices in the order the indices first use them.
+ *
+ * Vertex fetches then walk the buffer mostly forward. Unreferenced
+ * vertices are dropped.
+ * @param vertices Vertex attributes, reordered in place.
+ * @param floatsPerVertex Floats per vertex.
+ * @param indices Indices, rewritten in place.
+ */
+void OptimizeVertexFetch(std::vector<float>& vertices, size_t floatsPerVertex, std::vector<uint32_t>& indices);
+
+/**
+ * @brief Simplifies a triangle list with quadric error metric edge collapses.
+ *
+ * Garland and Heckbert's quadrics: every vertex accumulates the planes of
+ * the triangles around it (and of the open edges it lies on), so the error
+ * of moving it is its squared distance to those planes. Cheapest collapses
+ * go first, a pass collapses each neighbourhood at most once and passes
+ * repeat until the target or the error limit is reached. Vertices only move
+ * onto existing vertices, so the result indexes the same vertex buffer.
+ * Attribute seams (one position with several vertices) stay in place and
+ * open-edge vertices only slide along their edge; collapses that would flip
+ * a triangle are rejected.
+ * @param destination Receives the simplified triangle list, up to indexCount indices.
+ * @param indices Triangle list to simplify.
+ * @param indexCount Number of indices, a multiple of 3.
+ * @param vertices Vertex attributes, the position is the first 3 floats.
+ * @param vertexCount Number of vertices the indices refer to.
+ * @param floatsPerVertex Floats per vertex.
+ * @param targetIndexCount Stop once the result has at most this many indices.
+ * @param targetError Largest allowed error, in position units.
+ * @param resultError Receives the largest error of any collapse made, may be null.
+ * @return Number of indices written to destination.
+ */
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                    const float* vertices, size_t vertexCount, size_t floatsPerVertex,
+                    size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+/**
+ * @brief Average cache miss ratio: transformed vertices per triangle.
+ *
+ * Simulates a FIFO post-transform cache. 3.0 means no reuse at all, well
+ * ordered meshes get close to 0.5-0.7.
+ * @param indices Triangle list.
+ * @param indexCount Number of indices.
+ * @param cacheSize Simulated cache entries.
+ */
+float AverageCacheMissRatio(const uint32_t* indices, size_t indexCount, size_t cacheSize = 16);
+
+/**
+ * @brief Converts a float to an IEEE half float, rounding to nearest even.
+ */
+uint16_t FloatToHalf(float value);
+
+/**
+ * @brief Converts an IEEE half float back to float.
+ */
+float HalfToFloat(uint16_t half);
+
+/**
+ * @brief Packs a unit vector into signed normalized 10-10-10-2 (w = 0).
+ */
+uint32_t PackNormal(float x, float y, float z);
+
+/**
+ * @brief Packs a model vertex.
+ * @param v Position (3), texcoord (2), normal (3) and texture layer (1) floats.
+ */
+PackedVertex PackVertex(const float* v);
+
+#endif // MESH_OPTIMIZER_H
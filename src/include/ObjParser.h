@@ -0,0 +1,68 @@
+#pragma once
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct ObjCorner
+ * @brief One triangle corner: zero-based attribute indices, -1 when missing.
+ */
+struct ObjCorner {
+    int32_t vertex = -1;
+    int32_t texcoord = -1;
+    int32_t normal = -1;
+};
+
+/**
+ * @struct ObjShape
+ * @brief Run of triangles with one object/group name and one material.
+ */
+struct ObjShape {
+    std::string name;         ///< name of the last o or g statement
+    std::string material;     ///< name of the last usemtl statement, empty for none
+    uint32_t firstIndex = 0;  ///< first corner in ObjData::corners
+    uint32_t indexCount = 0;  ///< number of corners, a multiple of 3
+};
+
+/**
+ * @struct ObjData
+ * @brief Parsed Wavefront .obj file, faces triangulated.
+ */
+struct ObjData {
+    std::vector<float> positions;              ///< x, y, z per vertex
+    std::vector<float> texcoords;              ///< u, v per texture coordinate
+    std::vector<float> normals;                ///< x, y, z per normal
+    std::vector<ObjCorner> corners;            ///< triangles of all shapes, back to back in file order
+    std::vector<ObjShape> shapes;              ///< non-empty shapes in file order
+    std::vector<std::string> materialLibraries; ///< files named by mtllib statements
+};
+
+/**
+ * @brief Parses .obj text on several threads.
+ *
+ * The text is cut into line-aligned chunks that are parsed concurrently,
+ * each into its own attribute and face arrays. The chunks are then joined
+ * with prefix sums over their counts: relative (negative) indices are
+ * resolved against the attributes of the chunks before them and faces at
+ * the start of a chunk continue the shape the previous chunk ended in.
+ * Polygons are triangulated as fans. Only v, vt, vn, f, o, g, usemtl and
+ * mtllib statements are read.
+ * @param text Contents of the file.
+ * @param data Parsed model, replaced.
+ * @param threads Threads to use, 0 for LoadThreadCount().
+ * @param error Receives the reason on failure, may be null.
+ * @return false on malformed faces or indices out of range.
+ */
+bool ParseObj(std::string_view text, ObjData& data, unsigned threads = 0, std::string* error = nullptr);
+
+/**
+ * @brief Maps an .obj file and parses it with ParseObj().
+ * @return false if the file cannot be read or does not parse.
+ */
+bool LoadObjFile(const std::string& path, ObjData& data, unsigned threads = 0, std::string* error = nullptr);
+
+#endif // OBJ_PARSER_H
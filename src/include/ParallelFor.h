@@ -0,0 +1,55 @@
+#pragma once
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Worker threads to use for parallel loading work.
+ *
+ * One per hardware thread, CALC_LOAD_THREADS overrides it (1 runs serially).
+ */
+inline unsigned LoadThreadCount() {
+    if (const char* env = std::getenv("CALC_LOAD_THREADS")) {
+        int threads = std::atoi(env);
+        if (threads > 0) return static_cast<unsigned>(threads);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Calls body(i) for every i in [0, count), spread over threads.
+ *
+ * Threads take the next item from a shared counter, so items of uneven
+ * cost still balance. The calling thread works too and the call returns
+ * when every item is done. Items must not depend on each other.
+ * @param count Number of items.
+ * @param body Work for one item.
+ * @param threads Threads to use including the caller, 0 for LoadThreadCount().
+ */
+template <typename Body>
+void ParallelFor(size_t count, Body&& body, unsigned threads = 0) {
+    if (threads == 0) threads = LoadThreadCount();
+    size_t workers = std::min<size_t>(threads, count);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    auto work = [&] {
+        for (size_t i = next++; i < count; i = next++) body(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) pool.emplace_back(work);
+    work();
+    for (std::thread& thread : pool) thread.join();
+}
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,163 @@
+#pragma once
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "ShaderProgram.h"
+#include "RenderQueue.h"
+
+class TextRenderer;
+
+/**
+ * @class PerfHud
+ * @brief On-screen CPU/GPU frame timing overlay.
+ *
+ * Measures CPU time of each frame section with a steady clock and GPU time
+ * with GL_TIME_ELAPSED queries. Queries are double-buffered: a query set is
+ * read back two frames after it was issued, and a result that is not ready
+ * yet is dropped instead of waiting, so the pipeline never stalls.
+ * Keeps a rolling history per section, draws it as bar histograms with
+ * average and p99 values, and can record a capture to CSV.
+ */
+class PerfHud {
+public:
+    /**
+     * @brief Measured parts of a frame, in draw order.
+     */
+    enum Section {
+        Input,       ///< mouse/keyboard handling and camera update
+        ScreenPass,  ///< offscreen calculator display pass
+        ModelPass,   ///< calculator model draw
+        Skybox,      ///< skybox or placeholder cube
+        Overlay,     ///< HUD buttons and help overlay
+        SectionCount
+    };
+
+    /**
+     * @brief Creates timer queries and the histogram shader/buffers.
+     *
+     * Needs a current OpenGL context. GL objects live as long as the
+     * context, like the ones owned by TextRenderer.
+     */
+    PerfHud();
+
+    PerfHud(const PerfHud&) = delete;
+    PerfHud& operator=(const PerfHud&) = delete;
+
+    /**
+     * @brief Starts a frame and collects GPU results issued two frames ago.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Ends a frame and commits its CPU section times.
+     */
+    void EndFrame();
+
+    /**
+     * @brief Starts timing a section (CPU clock + GPU query).
+     * @param section Section to time, sections must not overlap.
+     */
+    void Begin(Section section);
+
+    /**
+     * @brief Stops timing a section.
+     * @param section Section started by Begin().
+     */
+    void End(Section section);
+
+    /**
+     * @brief Draws histograms and queues timing text.
+     *
+     * Expects blending enabled. Labels are queued on the text renderer,
+     * the caller draws them with its next TextRenderer::Flush() using a
+     * bottom-left origin ortho projection.
+     * @param text Renderer the labels are queued on.
+     * @param height Framebuffer height in pixels.
+     * @param projection Ortho projection with origin bottom-left.
+     */
+    void Render(TextRenderer& text, float height, const glm::mat4& projection);
+
+    /**
+     * @brief Sets heap allocation count shown for the last frame.
+     * @param count Number of allocations.
+     * @param bytes Allocated bytes.
+     */
+    void SetFrameAllocations(uint64_t count, uint64_t bytes) { allocCount = count; allocBytes = bytes; }
+
+    /**
+     * @brief Sets the draw, bind and uniform counts of the current frame.
+     * @param stats Counters of the frame's GLStateCache.
+     */
+    void SetRenderStats(const RenderStats& stats) { renderStats = stats; renderOfSet[currentSet] = stats; }
+
+    /**
+     * @brief Starts or stops recording frames into a CSV file.
+     * @param path Output file, opened when capture starts.
+     */
+    void ToggleCapture(const std::string& path);
+
+    /**
+     * @brief Whether a CSV capture is running.
+     * @return true while capturing.
+     */
+    bool IsCapturing() const { return capture.is_open(); }
+
+    /**
+     * @brief Returns a percentile of the section history.
+     * @param section Section to query.
+     * @param gpu true for GPU history, false for CPU.
+     * @param p Percentile in range 0..1.
+     * @return Time in milliseconds, 0 without samples.
+     */
+    float Percentile(Section section, bool gpu, float p) const;
+
+private:
+    static constexpr int HISTORY = 120;   ///< samples kept per section
+    static constexpr int QUERY_SETS = 2;  ///< frames in flight for timer queries
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Rolling buffer of samples in milliseconds.
+     */
+    struct History {
+        float samples[HISTORY] = {};
+        int next = 0;
+        int count = 0;
+
+        void Push(float ms);
+        float Average() const;
+    };
+
+    GLuint queries[QUERY_SETS][SectionCount];     ///< GL_TIME_ELAPSED query objects
+    bool issued[QUERY_SETS][SectionCount] = {};   ///< query was issued in that set
+    long frameOfSet[QUERY_SETS] = {};             ///< frame index that used the set
+    float cpuOfSet[QUERY_SETS][SectionCount] = {};///< CPU times kept for CSV rows
+    RenderStats renderOfSet[QUERY_SETS];          ///< render counters kept for CSV rows
+    int currentSet = 0;
+    long frameIndex = 0;
+
+    Clock::time_point sectionStart[SectionCount];
+    float cpuFrame[SectionCount] = {};
+
+    History cpuHistory[SectionCount];
+    History gpuHistory[SectionCount];
+
+    ShaderProgram shader;
+    GLint projectionLoc = -1;
+    GLuint VAO, VBO;
+    std::vector<float> bars;     ///< bar vertices (x, y, r, g, b), reused every frame
+    std::ofstream capture;
+    uint64_t allocCount = 0;     ///< heap allocations of the last frame
+    uint64_t allocBytes = 0;
+    RenderStats renderStats;     ///< draws and binds of the last frame
+};
+
+#endif // PERF_HUD_H
@@ -0,0 +1,177 @@
+#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+/**
+ * @brief Passes of the queued 3D draws, in execution order.
+ */
+enum class RenderPass : uint8_t {
+    Model,   ///< calculator model
+    Sky,     ///< skybox or the placeholder cube, drawn with GL_LEQUAL depth
+};
+
+/**
+ * @struct RenderStats
+ * @brief GL work issued through a GLStateCache in one frame.
+ */
+struct RenderStats {
+    uint32_t draws = 0;           ///< draw calls
+    uint32_t programBinds = 0;    ///< glUseProgram calls
+    uint32_t textureBinds = 0;    ///< glBindTexture calls
+    uint32_t vaoBinds = 0;        ///< glBindVertexArray calls
+    uint32_t uniformUploads = 0;  ///< glUniform* calls
+    uint32_t skippedBinds = 0;    ///< binds dropped because the object was already bound
+    uint32_t triangles = 0;       ///< triangles drawn
+
+    uint32_t Binds() const { return programBinds + textureBinds + vaoBinds; }  ///< all issued binds
+};
+
+/**
+ * @class GLStateCache
+ * @brief Remembers bound GL objects and skips binds that change nothing.
+ *
+ * Only sees state set through it, so code that binds objects directly
+ * (text renderer, perf overlay, offscreen passes) must be followed by
+ * Invalidate() before the cache is used again.
+ */
+class GLStateCache {
+public:
+    GLStateCache() { Invalidate(); }
+
+    /**
+     * @brief Starts a frame: clears the counters and forgets all bindings.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Forgets all bindings, the next bind of each kind is always issued.
+     */
+    void Invalidate();
+
+    /**
+     * @brief Makes a program current.
+     * @param program Program ID.
+     */
+    void UseProgram(GLuint program);
+
+    /**
+     * @brief Binds a texture to a texture unit.
+     * @param unit Unit index (0 for GL_TEXTURE0).
+     * @param target Texture target, e.g. GL_TEXTURE_2D.
+     * @param texture Texture ID.
+     */
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /**
+     * @brief Binds a vertex array object.
+     * @param vao VAO ID.
+     */
+    void BindVertexArray(GLuint vao);
+
+    /**
+     * @brief Uploads a mat4 uniform of the current program.
+     * @param location Uniform location.
+     * @param value Matrix.
+     */
+    void UniformMatrix4(GLint location, const glm::mat4& value);
+
+    /**
+     * @brief Draws with the bound VAO's element buffer.
+     * @param first First index to draw.
+     */
+    void DrawElements(GLenum mode, GLsizei count, GLenum type = GL_UNSIGNED_INT, GLuint first = 0);
+
+    /**
+     * @brief Draws non-indexed vertices of the bound VAO.
+     */
+    void DrawArrays(GLenum mode, GLint first, GLsizei count);
+
+    const RenderStats& Stats() const { return stats; }  ///< counters since BeginFrame()
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;  ///< binding not known to the cache
+    static constexpr int TEXTURE_UNITS = 4;
+
+    GLuint program;
+    GLuint vao;
+    GLuint activeUnit;
+    GLuint textures[TEXTURE_UNITS];  ///< bound texture per unit
+    GLenum targets[TEXTURE_UNITS];   ///< target it was bound to
+    RenderStats stats;
+};
+
+/**
+ * @struct DrawPacket
+ * @brief Everything needed to issue one queued draw.
+ */
+struct DrawPacket {
+    uint64_t key = 0;                      ///< sort key, filled by RenderQueue::Submit()
+    RenderPass pass = RenderPass::Model;
+    GLuint program = 0;
+    GLuint texture = 0;                    ///< bound to unit 0
+    GLenum textureTarget = GL_TEXTURE_2D;
+    GLuint screenTexture = 0;              ///< 2D texture bound to unit 1 when non-zero
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;                     ///< index count, or vertex count if not indexed
+    GLuint first = 0;                      ///< first index, or first vertex if not indexed
+    bool indexed = true;                   ///< indices from the VAO's element buffer
+    GLenum indexType = GL_UNSIGNED_INT;    ///< GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+    GLint modelLoc = -1;                   ///< model matrix uniform, -1 for none
+    glm::mat4 model = glm::mat4(1.0f);
+};
+
+/**
+ * @class RenderQueue
+ * @brief Collects draw packets for a frame and issues them in state order.
+ *
+ * Packets are sorted by (pass, program, texture, VAO) so draws sharing
+ * state are adjacent and the GLStateCache drops the repeated binds. The
+ * model matrix is only uploaded when it differs from the last upload of
+ * the same program. Storage is kept between frames, so a frame with the
+ * same number of packets does not allocate.
+ */
+class RenderQueue {
+public:
+    /**
+     * @brief Drops the packets of the previous frame.
+     */
+    void Clear();
+
+    /**
+     * @brief Queues a draw.
+     * @param packet Packet, its key is computed here.
+     */
+    void Submit(const DrawPacket& packet);
+
+    /**
+     * @brief Issues the queued draws of one pass, sorting the queue first if needed.
+     * @param gl State cache the binds and draws go through.
+     * @param pass Pass to draw.
+     */
+    void Execute(GLStateCache& gl, RenderPass pass);
+
+    /**
+     * @brief Sort key of a draw: pass, then program, texture and VAO.
+     */
+    static uint64_t SortKey(RenderPass pass, GLuint program, GLuint texture, GLuint vao);
+
+private:
+    std::vector<DrawPacket> packets;
+    bool sorted = true;
+
+    /// Model matrix last uploaded to one program's uniform, which keeps its value per program
+    struct ModelUpload {
+        GLuint program = 0;
+        GLint location = -1;
+        glm::mat4 model{ 1.0f };
+    };
+    std::vector<ModelUpload> modelUploads; ///< uploads of this frame, one per program and location
+};
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * @brief Uniform block binding point of the per-frame camera/lighting block.
+ *
+ * Programs that declare `FrameUniforms` bind it here, see UniformBuffer.
+ */
+constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+
+/**
+ * @class ShaderProgram
+ * @brief Linked shader program with its uniform locations resolved up front.
+ *
+ * Right after linking, the active uniforms are enumerated once and their
+ * locations stored, so render code looks a location up at setup time and
+ * only calls glUniform* per draw. GL objects live as long as the context.
+ */
+class ShaderProgram {
+public:
+    ShaderProgram() = default;
+
+    /**
+     * @brief Compiles and links a program and caches its uniform locations.
+     * @param vertexPath Path to vertex shader source.
+     * @param fragmentPath Path to fragment shader source.
+     */
+    ShaderProgram(const char* vertexPath, const char* fragmentPath);
+
+    /**
+     * @brief Location of an active uniform from the link-time table.
+     * @param name Uniform name (without "[0]" for arrays).
+     * @return Location, or -1 if the program has no such active uniform.
+     */
+    GLint Uniform(std::string_view name) const;
+
+    /**
+     * @brief Binds a uniform block of this program to a binding point.
+     * @param blockName Name of the uniform block.
+     * @param binding Binding point, e.g. FRAME_UNIFORMS_BINDING.
+     */
+    void BindBlock(const char* blockName, GLuint binding) const;
+
+    void Use() const { glUseProgram(id); }   ///< makes the program current
+    GLuint ID() const { return id; }         ///< OpenGL program ID
+
+private:
+    GLuint id = 0;
+    std::vector<std::pair<std::string, GLint>> uniforms;  ///< active uniforms and their locations
+};
+
+/**
+ * @class UniformBuffer
+ * @brief Uniform buffer object attached to a fixed binding point.
+ *
+ * Filled once per frame and read by every program that binds a block to
+ * the same point, instead of uploading the same uniforms to each program.
+ */
+class UniformBuffer {
+public:
+    /**
+     * @brief Creates the buffer and attaches it to a binding point.
+     * @param binding Binding point shared with ShaderProgram::BindBlock().
+     * @param size Size of the block in bytes (std140 layout).
+     */
+    UniformBuffer(GLuint binding, size_t size);
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    /**
+     * @brief Replaces the buffer contents.
+     * @param data Block data, size bytes as given to the constructor.
+     */
+    void Update(const void* data);
+
+private:
+    GLuint ubo = 0;
+    size_t size;
+};
+
+#endif // SHADER_PROGRAM_H
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class SpscQueue
+ * @brief Fixed-capacity lock-free queue for one producer and one consumer thread.
+ *
+ * A ring buffer with separate head and tail counters; each side only writes
+ * its own counter, so no locks or compare-and-swap loops are needed.
+ * @tparam T Trivially copyable element type.
+ * @tparam N Capacity, a power of two.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    /**
+     * @brief Appends an element (producer thread).
+     * @return false if the queue is full and the element was dropped.
+     */
+    bool Push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        items[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element (consumer thread).
+     * @return false if the queue is empty.
+     */
+    bool Pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether the queue holds no elements (either thread).
+     */
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[N];
+    alignas(64) std::atomic<size_t> head{0};  ///< next element to pop
+    alignas(64) std::atomic<size_t> tail{0};  ///< next free slot
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TextRenderer;
+
+/**
+ * @struct LayoutLine
+ * @brief One laid out line of text.
+ */
+struct LayoutLine {
+    std::string text;    ///< UTF-8 text of the line (may end or start with an ellipsis)
+    float width = 0.0f;  ///< width in pixels at the layout scale
+    float x = 0.0f;      ///< left edge relative to the layout box, right-aligned
+};
+
+/**
+ * @class TextLayout
+ * @brief Right-aligned line breaking and truncation for the calculator display.
+ *
+ * Each call walks the text once, accumulating glyph advances as it goes,
+ * and finishes overflowing text with an ellipsis in the same pass. The
+ * result is cached: calling again with the same text and parameters returns
+ * immediately, so an unchanged display costs one string compare per frame.
+ * Line buffers are reused, steady-state layouts do not allocate.
+ */
+class TextLayout {
+public:
+    /**
+     * @brief Breaks text into up to maxLines lines of at most maxWidth.
+     *
+     * Characters fill a line until the next one would not fit. Text that
+     * does not fit into maxLines ends the last line with "…".
+     * @param renderer Provides glyph advances.
+     * @param text UTF-8 text.
+     * @param scale Size multiplier.
+     * @param maxWidth Width of the layout box in pixels.
+     * @param maxLines Maximum number of lines.
+     * @return true if the layout was recomputed.
+     */
+    bool Wrap(TextRenderer& renderer, std::string_view text, float scale, float maxWidth, int maxLines);
+
+    /**
+     * @brief Fits text on one line by shrinking it, then cutting it from the left.
+     *
+     * The scale shrinks down to minScale. Text that is still too wide loses
+     * leading characters, which are replaced by "…", keeping a leading '-'.
+     * @param renderer Provides glyph advances.
+     * @param text UTF-8 text.
+     * @param scale Preferred size multiplier.
+     * @param minScale Smallest allowed size multiplier.
+     * @param maxWidth Width of the layout box in pixels.
+     * @return true if the layout was recomputed.
+     */
+    bool FitLine(TextRenderer& renderer, std::string_view text, float scale, float minScale, float maxWidth);
+
+    /**
+     * @brief Forces the next call to lay out again (e.g. after a font change).
+     */
+    void Invalidate() { valid = false; }
+
+    size_t LineCount() const { return lineCount; }                    ///< number of laid out lines
+    const LayoutLine& Line(size_t i) const { return lines[i]; }       ///< i-th line, top to bottom
+    float Scale() const { return layoutScale; }                       ///< scale the lines were laid out at
+
+private:
+    enum class Mode { Wrap, FitLine };
+
+    /**
+     * @brief Compares the inputs with the cached ones and stores them if different.
+     * @return true if the cached layout is still valid.
+     */
+    bool Cached(Mode mode, std::string_view text, float scale, float minScale, float maxWidth, int maxLines);
+
+    /**
+     * @brief Starts a new empty line, reusing its buffer.
+     */
+    LayoutLine& NewLine();
+
+    /**
+     * @brief Right-aligns the laid out lines within the box.
+     */
+    void Align(float maxWidth);
+
+    // cache key
+    bool valid = false;
+    Mode keyMode = Mode::Wrap;
+    std::string keyText;
+    float keyScale = 0.0f, keyMinScale = 0.0f, keyWidth = 0.0f;
+    int keyLines = 0;
+
+    std::vector<LayoutLine> lines;
+    size_t lineCount = 0;
+    float layoutScale = 1.0f;
+};
+
+#endif // TEXT_LAYOUT_H
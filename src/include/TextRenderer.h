@@ -2,32 +2,63 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <glad/glad.h>
+#include "GlyphAtlas.h"
+#include "ShaderProgram.h"
 
 /**
  * @struct Character
  * @brief Structure to hold font character information.
  * 
- * Stores OpenGL texture ID, glyph size, bearing, and advance distance
- * for each character in the font.
+ * Stores the glyph's rectangle in the font atlas, glyph size, bearing,
+ * and advance distance for each character in the font.
  */
 struct Character {
-    GLuint textureID;     ///< ID handle of the glyph texture
+    glm::vec2 uvMin;       ///< Top-left texture coordinate in the atlas
+    glm::vec2 uvMax;       ///< Bottom-right texture coordinate in the atlas
     glm::ivec2 size;       ///< Size of glyph
     glm::ivec2 bearing;    ///< Offset from baseline to left/top of glyph
     unsigned int advance;  ///< Offset to advance to next glyph
+    int shelf;             ///< Atlas shelf holding the bitmap, -1 for empty glyphs
 };
 
+/**
+ * @brief Decodes the UTF-8 sequence starting at text[i] and advances i past it.
+ *
+ * Malformed or truncated sequences decode to U+FFFD and consume one byte,
+ * so rendering never stalls on bad input.
+ * @param text UTF-8 string.
+ * @param i Byte offset, must be < text.size().
+ * @return The decoded codepoint.
+ */
+char32_t NextCodepoint(std::string_view text, size_t& i);
+
 /**
  * @class TextRenderer
  * @brief Class for text rendering using FreeType and OpenGL.
  * 
  * Initializes font loading, glyph texture preparation, and text rendering.
+ * All glyphs share one atlas texture, so a string needs a single texture bind.
+ * Glyphs are stored as signed distance fields, so the one atlas stays sharp
+ * at every scale (including the magnified 3D calculator screen).
+ *
+ * Text is UTF-8. Glyphs are rasterized on first use and cached; when the
+ * atlas is full the least recently drawn shelf of glyphs is evicted.
+ * Codepoints the font lacks render as a fallback glyph (U+FFFD or '?').
+ *
+ * Text that rarely changes can be retained instead: AddText() calls between
+ * BeginStaticText() and EndStaticText() are laid out once into a range of a
+ * persistent VBO, and DrawStaticText() draws that range with one call.
+ * Strings are queued with AddText() into a CPU vertex array (color is a
+ * vertex attribute) and drawn by Flush() with one upload and one draw call.
  */
 class TextRenderer {
 public:
@@ -39,40 +70,226 @@ public:
     TextRenderer(unsigned int width, unsigned int height);
 
     /**
-     * @brief Loads font from file and prepares glyph textures.
+     * @brief Releases the FreeType face kept open for lazy rasterization.
+     */
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    /**
+     * @brief Loads font from file and packs its printable ASCII glyphs into the atlas texture.
+     *
+     * Other glyphs are added on first use. The packed atlas and metrics are
+     * cached on disk (in $CALC_FONT_CACHE, $XDG_CACHE_HOME/ivs_calculator or
+     * ~/.cache/ivs_calculator; CALC_FONT_CACHE=off disables it), keyed by the
+     * font's content hash, size and glyph mode. On a hit the cache file is
+     * memory-mapped and FreeType is not touched until an uncached glyph is
+     * needed. Glyphs are rendered as signed distance fields when FreeType supports it
+     * (2.11+), otherwise as plain coverage bitmaps.
      * @param fontPath Path to .ttf font file.
-     * @param fontSize Size of glyphs in pixels.
+     * @param fontSize Size of glyphs in pixels; layout metrics are in this size.
      */
     void Load(const std::string& fontPath, unsigned int fontSize);
 
     /**
-     * @brief Renders given text string to screen at specified position.
+     * @brief Queues text string for the next Flush().
+     * @param text The UTF-8 string to render.
+     * @param x X position in pixels.
+     * @param y Y position in pixels.
+     * @param scale Size multiplier.
+     * @param color RGB color of text.
+     */
+    void AddText(std::string_view text, float x, float y, float scale, glm::vec3 color);
+
+    /**
+     * @brief Draws all queued text with one buffer upload and one draw call.
+     *
+     * Uses the projection currently set on the text shader. Does nothing
+     * when the queue is empty.
+     */
+    void Flush();
+
+    /**
+     * @brief Renders given text string immediately (AddText() + Flush()).
      * @param text The string to render.
      * @param x X position in pixels.
      * @param y Y position in pixels.
      * @param scale Size multiplier.
      * @param color RGB color of text.
      */
-    void RenderText(const std::string& text, float x, float y, float scale, glm::vec3 color);
+    void RenderText(std::string_view text, float x, float y, float scale, glm::vec3 color);
+
+    /**
+     * @brief Creates an empty retained text object.
+     * @return Handle for the other *StaticText() calls.
+     */
+    int CreateStaticText();
+
+    /**
+     * @brief Starts (re)recording a retained text object.
+     *
+     * Until EndStaticText(), AddText() records into the object instead of
+     * queueing for Flush().
+     * @param id Handle from CreateStaticText().
+     */
+    void BeginStaticText(int id);
+
+    /**
+     * @brief Finishes recording, lays the text out and uploads it.
+     */
+    void EndStaticText();
+
+    /**
+     * @brief Draws a retained text object with one draw call.
+     *
+     * Uses the projection currently set on the text shader. The object is
+     * rebuilt first if glyph eviction invalidated its texture coordinates.
+     * @param id Handle from CreateStaticText().
+     */
+    void DrawStaticText(int id);
 
     /**
      * @brief Calculates the width of rendered text.
-     * @param text The string to measure.
+     * @param text The UTF-8 string to measure.
      * @param scale Size multiplier.
      * @return Width of the text in pixels.
      */
-    float CalculateTextWidth(const std::string& text, float scale);
+    float CalculateTextWidth(std::string_view text, float scale);
+
+    /**
+     * @brief Returns horizontal advance of a single character.
+     * @param codepoint Unicode codepoint to measure.
+     * @param scale Size multiplier.
+     * @return Advance in pixels (of the fallback glyph if the font lacks it).
+     */
+    float GlyphAdvance(char32_t codepoint, float scale);
+
+    /**
+     * @brief Sets the projection used by Flush() and DrawStaticText().
+     *
+     * The upload is skipped when the matrix did not change.
+     * @param projection Orthographic projection of the target in pixels.
+     */
+    void SetProjection(const glm::mat4& projection);
 
     /**
      * @brief Getter for internal shader program ID.
      * @return GLuint shader program ID.
      */
-    GLuint GetShaderID() const { return shaderID; }
+    GLuint GetShaderID() const { return shader.ID(); }
 
 private:
+    /**
+     * @brief Returns the cached glyph for a codepoint, rasterizing it on a miss.
+     *
+     * Marks the glyph's shelf as used by the pending batch.
+     */
+    const Character& Glyph(char32_t codepoint);
+
+    /**
+     * @brief Rasterizes a glyph into the atlas.
+     * @param codepoint Unicode codepoint.
+     * @param out Receives the glyph, or the fallback glyph if the font lacks it.
+     * @return false if the atlas has no room even after eviction.
+     */
+    bool Rasterize(char32_t codepoint, Character& out);
+
+    /**
+     * @brief Empties the least recently drawn shelf that can hold a w x h bitmap.
+     * @return false if every such shelf is used by the pending batch.
+     */
+    bool EvictShelf(int w, int h);
+
+    /**
+     * @brief Opens the FreeType face on first use.
+     * @return false if the font cannot be loaded (reported once).
+     */
+    bool OpenFace();
+
+    /**
+     * @brief Restores glyphs and atlas from a cache file.
+     * @return false if the file is missing, stale or malformed.
+     */
+    bool LoadAtlasCache(const std::string& path);
+
+    /**
+     * @brief Writes the current glyphs and atlas to a cache file.
+     */
+    void SaveAtlasCache(const std::string& path) const;
+
+    /**
+     * @brief Points fallback at the glyph cached under fallbackChar and pins its shelf.
+     */
+    void ResolveFallback();
+
+    /**
+     * @brief Copies a rectangle of the CPU atlas to the texture.
+     */
+    void UploadRect(const AtlasRect& rect);
+
+    /**
+     * @brief Appends the quads of one string to a vertex array.
+     */
+    void AppendQuads(std::vector<float>& out, std::string_view text, float x, float y, float scale, glm::vec3 color);
+
+    /**
+     * @brief Lays out a retained text object from its runs and uploads its range.
+     */
+    void BuildStaticText(int id);
+
+    /**
+     * @struct StaticRun
+     * @brief One AddText() call recorded into a retained text object.
+     */
+    struct StaticRun {
+        size_t begin, end;  ///< byte range in StaticText::chars
+        float x, y, scale;
+        glm::vec3 color;
+    };
+
+    /**
+     * @struct StaticText
+     * @brief Retained text: its source runs and its vertex range in the static VBO.
+     */
+    struct StaticText {
+        std::string chars;            ///< text of all runs, kept to rebuild after eviction
+        std::vector<StaticRun> runs;
+        GLint first = 0;              ///< first vertex in the static VBO
+        GLsizei count = 0;            ///< vertices currently used
+        GLsizei capacity = 0;         ///< vertices reserved for this object
+        uint64_t epoch = 0;           ///< atlas epoch the vertices were built in
+    };
+
     GLuint VAO, VBO;                      ///< OpenGL vertex array and buffer objects
-    GLuint shaderID;                      ///< OpenGL shader program ID
-    std::map<char, Character> Characters; ///< Map storing loaded glyphs.
+    ShaderProgram shader;                 ///< Text shader program
+    GLint projectionLoc = -1;             ///< Location of the "projection" uniform
+    glm::mat4 currentProjection{ 0.0f };  ///< Last uploaded projection
+    GLuint atlasTexture = 0;              ///< Single texture holding all glyphs
+    bool sdfGlyphs = false;               ///< Atlas holds distance fields instead of coverage
+    std::vector<float> batch;             ///< Queued vertices (x, y, u, v, r, g, b)
+    size_t vboCapacity = 0;               ///< Size of VBO storage in bytes
+
+    FT_Library ft = nullptr;              ///< FreeType library, open while a font is loaded
+    FT_Face face = nullptr;               ///< Current font face, opened lazily
+    std::string fontPath;                 ///< Font file, empty if it failed to load
+    unsigned int fontSize = 0;            ///< Pixel size glyphs are rasterized at
+    uint64_t fontHash = 0;                ///< Content hash of the font file
+    char32_t fallbackChar = U'?';         ///< Codepoint of the fallback glyph
+    GlyphAtlas atlas{ 1024, 512 };        ///< CPU copy of the atlas texture
+    std::unordered_map<char32_t, Character> Characters; ///< Glyph cache by codepoint
+    Character fallback{};                 ///< Drawn for codepoints the font lacks
+    float asciiAdvance[128] = {};         ///< Advances of ASCII glyphs in pixels at scale 1
+    std::vector<uint64_t> shelfLastUse;   ///< Flush generation each shelf was last used in
+    uint64_t generation = 1;              ///< Incremented by every Flush()
+
+    GLuint staticVAO, staticVBO;          ///< Persistent buffer holding all retained text
+    size_t staticVboBytes = 0;            ///< Size of static VBO storage in bytes
+    std::vector<float> staticVertices;    ///< CPU copy of the static VBO
+    std::vector<float> staticScratch;     ///< Vertices of the object being built
+    std::vector<StaticText> statics;      ///< Retained text objects by handle
+    int recordingStatic = -1;             ///< Object AddText() records into, -1 for none
+    uint64_t atlasEpoch = 1;              ///< Incremented whenever a shelf is evicted
 };
 
 #endif // TEXT_RENDERER_H
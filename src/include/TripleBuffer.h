@@ -0,0 +1,64 @@
+#pragma once
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/**
+ * @class TripleBuffer
+ * @brief Lock-free single-writer, single-reader exchange of the latest value.
+ *
+ * The writer fills Back() and publishes it, the reader picks up the most
+ * recently published slot with Update() and reads Front(). Three slots mean
+ * neither side ever waits for the other: the writer always has a slot the
+ * reader is not looking at, and values published faster than the reader
+ * consumes them are simply replaced. A published slot comes back to the
+ * writer two publishes later, so Back() holds stale data the writer has to
+ * overwrite (or compare against) before publishing.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /**
+     * @brief Slot owned by the writer.
+     */
+    T& Back() { return slots[back]; }
+
+    /**
+     * @brief Makes Back() the latest value and hands the writer another slot.
+     */
+    void Publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * @brief Takes the latest published value, if there is a newer one.
+     * @return true if Front() changed.
+     */
+    bool Update() {
+        if (!Fresh()) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    /**
+     * @brief Slot owned by the reader, valid until the next Update().
+     */
+    const T& Front() const { return slots[front]; }
+
+    /**
+     * @brief Whether a value was published since the reader's last Update().
+     */
+    bool Fresh() const { return middle.load(std::memory_order_acquire) & FRESH; }
+
+private:
+    static constexpr unsigned INDEX = 3;  ///< slot index bits of middle
+    static constexpr unsigned FRESH = 4;  ///< set when middle holds an unread value
+
+    T slots[3] = {};
+    unsigned back = 0;                   ///< writer slot
+    alignas(64) std::atomic<unsigned> middle{1};
+    alignas(64) unsigned front = 2;      ///< reader slot
+};
+
+#endif // TRIPLE_BUFFER_H
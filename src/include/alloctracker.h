@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <cstdint>
+
+/**
+ * @file alloctracker.h
+ * @brief Heap allocation counters fed by a global operator new hook.
+ *
+ * Linking alloctracker.cpp replaces the global operator new/delete with
+ * versions that count every allocation per thread and per process. The
+ * GUI uses it to verify that steady-state frames do not allocate, the
+ * tests use it to check allocation-free code paths.
+ */
+
+/**
+ * @brief Allocation totals since program start
+ */
+struct AllocStats {
+    uint64_t count = 0;  ///< number of operator new calls
+    uint64_t bytes = 0;  ///< requested bytes
+};
+
+/**
+ * @brief Returns totals of the calling thread
+ */
+AllocStats thread_alloc_stats();
+
+/**
+ * @brief Returns totals of all threads
+ */
+AllocStats process_alloc_stats();
+
+/**
+ * @brief Measures allocations of the calling thread since construction
+ */
+class AllocScope {
+public:
+    AllocScope() : start(thread_alloc_stats()) {}
+
+    /**
+     * @brief Allocations made by this thread since the scope started
+     * @return Difference of thread totals
+     */
+    AllocStats delta() const {
+        AllocStats now = thread_alloc_stats();
+        return { now.count - start.count, now.bytes - start.bytes };
+    }
+
+private:
+    AllocStats start;
+};
+
+#endif // ALLOCTRACKER_H
@@ -0,0 +1,44 @@
+#ifndef CPUDISPATCH_H
+#define CPUDISPATCH_H
+
+/**
+ * @file cpudispatch.h
+ * @brief Runtime selection of SIMD kernel variants.
+ *
+ * Hot kernels are compiled for several instruction set levels. The best
+ * level supported by the CPU is detected once via CPUID and can be forced
+ * with the CALC_ISA environment variable (baseline, avx2, avx512).
+ */
+
+/**
+ * @brief Instruction set levels kernels can be compiled for, ordered from lowest
+ */
+enum class IsaLevel {
+	Baseline, ///< plain x86-64 / portable C++
+	AVX2,     ///< AVX2 + FMA
+	AVX512    ///< AVX-512F
+};
+
+/**
+ * @brief Checks whether the running CPU supports the given level
+ * @param level Level to check
+ * @return true if kernels compiled for level can run on this CPU
+ */
+bool isaSupported(IsaLevel level);
+
+/**
+ * @brief Returns the level selected for this process
+ *
+ * Detected on first call, honouring CALC_ISA if it names a supported level.
+ * @return Active instruction set level
+ */
+IsaLevel activeIsa();
+
+/**
+ * @brief Returns printable name of a level
+ * @param level Level to name
+ * @return Name as accepted by CALC_ISA
+ */
+const char* isaName(IsaLevel level);
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef MATHLIBRARY_H
 #define MATHLIBRARY_H
 
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
+#include "cpudispatch.h"
 
 /**
  * @class Calculator
@@ -100,6 +102,28 @@ class Calculator {
 		 * @throws std::invalid_argument if either a or b is not an integer
 		 */
 		static double modulo(double a, double b);
+
+		/**
+		 * @brief Adds values and their squares to running totals
+		 *
+		 * Batch kernel used by the standard deviation tool. Runs the SIMD
+		 * variant selected by activeIsa().
+		 * @param values Array of values
+		 * @param count Number of values
+		 * @param sum Running sum, updated in place
+		 * @param sum_squares Running sum of squares, updated in place
+		 */
+		static void accumulate(const double* values, size_t count, double& sum, double& sum_squares);
+
+		/**
+		 * @brief Adds values and their squares to running totals using a given kernel variant
+		 * @param values Array of values
+		 * @param count Number of values
+		 * @param sum Running sum, updated in place
+		 * @param sum_squares Running sum of squares, updated in place
+		 * @param level Kernel variant to run, must be supported by the CPU
+		 */
+		static void accumulate(const double* values, size_t count, double& sum, double& sum_squares, IsaLevel level);
 };
 
 #endif
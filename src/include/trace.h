@@ -0,0 +1,97 @@
+#pragma once
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * @file trace.h
+ * @brief Lightweight scoped tracing exported in Chrome trace format.
+ *
+ * Every thread records events into its own fixed-size ring buffer without
+ * locking. At exit the buffers are written as Chrome trace JSON which can be
+ * opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Tracing is compiled in only when CALC_TRACE is defined (`make TRACE=1`,
+ * or `-DENABLE_TRACING=ON` with CMake). Otherwise all TRACE_* macros expand
+ * to nothing.
+ */
+
+#ifdef CALC_TRACE
+
+#include <cstdint>
+
+namespace trace {
+
+/**
+ * @brief Returns nanoseconds elapsed since tracing started
+ */
+uint64_t now_ns();
+
+/**
+ * @brief Records a complete ('X') event on the calling thread
+ * @param name Static string naming the zone
+ * @param start_ns Start time from now_ns()
+ * @param end_ns End time from now_ns()
+ */
+void record_zone(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Records an instant ('i') event with an optional text argument
+ * @param name Static string naming the event
+ * @param arg Text stored with the event (truncated), may be nullptr
+ */
+void record_instant(const char* name, const char* arg);
+
+/**
+ * @brief Names the calling thread in the exported trace
+ * @param name Static string with the thread name
+ */
+void set_thread_name(const char* name);
+
+/**
+ * @brief Writes all recorded events as Chrome trace JSON
+ * @param path Output file path, nullptr writes calculator_trace.json
+ * @return true if the file was written
+ */
+bool write_chrome_json(const char* path);
+
+/**
+ * @brief RAII helper recording a zone from construction to destruction
+ */
+struct Zone {
+    const char* name;   ///< static zone name
+    uint64_t start;     ///< start timestamp in ns
+
+    explicit Zone(const char* zone_name) : name(zone_name), start(now_ns()) {}
+    ~Zone() { record_zone(name, start, now_ns()); }
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// records a zone covering the rest of the enclosing scope
+#define TRACE_ZONE(name) trace::Zone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+/// starts a zone ended by TRACE_END, for sections that are not a single scope
+#define TRACE_BEGIN(var, name) const uint64_t var = trace::now_ns(); const char* const var##_name = name
+/// ends a zone started by TRACE_BEGIN
+#define TRACE_END(var) trace::record_zone(var##_name, var, trace::now_ns())
+/// records an instant event with a text argument
+#define TRACE_INSTANT(name, arg) trace::record_instant(name, arg)
+/// names the calling thread
+#define TRACE_THREAD_NAME(name) trace::set_thread_name(name)
+/// writes the trace file
+#define TRACE_WRITE(path) trace::write_chrome_json(path)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_BEGIN(var, name) ((void)0)
+#define TRACE_END(var) ((void)0)
+#define TRACE_INSTANT(name, arg) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_WRITE(path) ((void)0)
+
+#endif // CALC_TRACE
+
+#endif // TRACE_H
@@ -63,9 +63,8 @@
  * used for i/o, containers, math, strings, threading, etc.
  */
 #include <iostream>       // prints to terminal
-#include <fstream>        // reads shader files
+#include <fstream>        // reads model files
 #include <vector>         // dynamic arrays
-#include <sstream>        // stringstream for reading text
 #include <string>         // string manipulation
 #include <cmath>          // math functions like sin, cos, pow
 #include <thread>         // runs texture loader in background
@@ -73,6 +72,17 @@
 #include <unordered_set>  // stores allowed input values for filtering
 #include <stack>          // Needed for dummy calculate
 #include <stdexcept>      // For throw runtime_error
+#include <cstdlib>        // getenv for trace output path
+#include <cstdio>         // snprintf into fixed frame buffers
+#include <optional>       // benchmark state, only present with --bench
+#include <atomic>         // flags shared with the loader and simulation threads
+#include <mutex>          // idle simulation thread sleeps on a condition variable
+#include <condition_variable>
+#include <algorithm>      // material texture lookup
+#include <chrono>         // mesh load timing
+#include <cstddef>        // offsetof for packed vertex attributes
+#include <map>            // material ids by name
+#include <memory>         // processed meshes handed to the GL thread
 
 /**
  * @brief image loader (stb_image)
@@ -85,9 +95,9 @@
 /**
  * @brief obj file model loader (tinyobjloader)
  *
- * reads .obj mesh files and loads vertices, textures, and materials.
+ * reads the .mtl material libraries of .obj models.
  */
-#include "tiny_obj_loader.h"                  // loads 3d models into mesh structs
+#include "tiny_obj_loader.h"                  // reads .mtl material libraries
 
 /**
  * @brief 2d text rendering module (optional)
@@ -95,6 +105,22 @@
  * renders on-screen text using freetype and opengl.
  */
 #include "TextRenderer.h"                   // disabled for now, can be enabled for HUD text
+#include "TextLayout.h"
+#include "PerfHud.h"                        // cpu/gpu frame timing overlay (F3)
+#include "ShaderProgram.h"                  // programs with cached uniform locations, UBOs
+#include "alloctracker.h"                   // per-frame heap allocation counters
+#include "Benchmark.h"                      // headless --bench mode
+#include "HeadlessContext.h"                // EGL context for --bench without a display
+#include "InputRecorder.h"                  // --record / --replay input sessions
+#include "SpscQueue.h"                      // input events to the simulation thread
+#include "TripleBuffer.h"                   // simulation snapshots to the render loop
+#include "RenderQueue.h"                    // sorted 3d draws with redundant bind elimination
+#include "MeshOptimizer.h"                  // vertex welding, cache ordering, packed vertices
+#include "MeshCache.h"                      // processed meshes cached on disk
+#include "FileCache.h"                      // cache directory and source hashing
+#include "ObjParser.h"                      // parallel .obj parsing
+#include "ParallelFor.h"                    // mesh processing spread over cores
+#include "JobSystem.h"                      // asset loader jobs, GL upload queue
 /**
  * @brief project math library
  *
@@ -102,13 +128,86 @@
  */
 #include "mathlibrary.h"
 
-// camera distance variables
-// radius controls current zoom, target_radius smooths the zoom animation
-static float radius = 5.0f;
-float target_radius = 5.0f;
+/**
+ * @brief scoped tracing zones (compiled out unless CALC_TRACE is defined)
+ */
+#include "trace.h"
+
 //double calculate(const std::string& expr);
 
-bool show_help_overlay = false;
+// performance overlay state, F3 toggles the overlay, F4 starts/stops a csv capture
+// (keys are handled on the simulation thread, the render loop reads the flags)
+std::atomic<bool> show_perf_hud = false;
+std::atomic<bool> perf_capture_toggled = false;
+
+// render on demand: window refreshes set this, and the render loop sleeps in
+// glfwWaitEventsTimeout while it is false and no new simulation snapshot arrived
+bool redraw_requested = true;
+
+// --record writes every input event to a file, --replay feeds a recording back in
+// (both run on the simulation thread)
+InputRecorder input_recorder;
+double input_record_start = 0.0; // glfwGetTime() when the recording started
+
+// input events from the glfw callbacks (main thread) to the simulation thread
+SpscQueue<InputEvent, 1024> input_queue;
+std::mutex sim_wake_mutex;         // only guards sleeping, see queue_input()
+std::condition_variable sim_wake;  // wakes a settled simulation thread
+
+/**
+ * @brief mouse state tracked from input events on the simulation thread
+ *
+ * buttons and cursor are read from here instead of polling glfw, so a
+ * replayed session drives the simulation exactly like a live one. a button
+ * released before the simulation looked at it is still reported pressed
+ * once, like GLFW_STICKY_MOUSE_BUTTONS, so quick clicks are not lost.
+ */
+struct MouseState {
+    double x = 0.0, y = 0.0;
+    bool down[GLFW_MOUSE_BUTTON_LAST + 1] = {};
+    bool sticky[GLFW_MOUSE_BUTTON_LAST + 1] = {};
+} mouse;
+
+/**
+ * @brief sticky mouse button query, replaces glfwGetMouseButton
+ * @param button glfw mouse button
+ * @return GLFW_PRESS or GLFW_RELEASE
+ */
+int mouse_button(int button) {
+    if (mouse.down[button]) return GLFW_PRESS;
+    if (mouse.sticky[button]) {
+        mouse.sticky[button] = false;
+        return GLFW_PRESS;
+    }
+    return GLFW_RELEASE;
+}
+
+/**
+ * @brief cursor position query, replaces glfwGetCursorPos
+ */
+void cursor_pos(double* x, double* y) {
+    *x = mouse.x;
+    *y = mouse.y;
+}
+
+/**
+ * @brief hands an input event from a glfw callback to the simulation thread
+ */
+void queue_input(InputEventType type, int code = 0, int action = 0, int mods = 0, double x = 0.0, double y = 0.0) {
+    InputEvent event;
+    event.time = static_cast<float>(glfwGetTime() - input_record_start);
+    event.type = type;
+    event.action = static_cast<uint8_t>(action);
+    event.mods = static_cast<uint16_t>(mods);
+    event.code = code;
+    event.x = static_cast<float>(x);
+    event.y = static_cast<float>(y);
+    if (!input_queue.Push(event)) return; // simulation stalled, drop rather than block the ui
+
+    // taking the mutex orders the push before the simulation's emptiness check
+    { std::lock_guard<std::mutex> lock(sim_wake_mutex); }
+    sim_wake.notify_one();
+}
 
 
 // stores the current input string from user (e.g. "6^2+3")
@@ -119,6 +218,7 @@ std::string pending_operator; // "+", "-", "*", or "/"
 bool just_evaluated = false; // did we just finish "="?
 std::string full_expression; // the full typed equation
 std::string current_value;   // the evaluated result
+unsigned long display_version = 0; // bumped whenever the strings above may change
 
 
 /**
@@ -140,28 +240,64 @@ std::string root_value;
 
 /**
  * @struct SubMesh
- * @brief Represents a single drawable part of a 3D mesh with a material.
+ * @brief Represents a single part of a 3D mesh with a material.
  *
- * Contains the geometry (vertices and indices) and OpenGL buffer handles.
+ * A range of the mesh's shared vertex and index buffers.
  */
 struct SubMesh {
-    GLuint vao; //!< Vertex Array Object ID.
-    GLuint vbo; //!< Vertex Buffer Object ID.
-    GLuint ebo; //!< Element Buffer Object ID.
-    std::vector<float> vertices; //!< Flattened list of vertex attributes (position, texcoord, normal).
-    std::vector<unsigned int> indices; //!< Index buffer for drawing.
-    int material_ID; //!< Index of the material associated with this submesh.
+    GLuint first_index;   //!< First index of the part in the shared index buffer.
+    GLsizei index_count;  //!< Number of indices of the part.
+    int material_ID;      //!< Index of the material associated with this submesh.
 };
 
 
+// texture layer of materials without a texture and of the material showing the rendered display
+constexpr float NO_TEXTURE_LAYER = -2.0f;
+constexpr float SCREEN_LAYER = -1.0f;
+const char* const SCREEN_MATERIAL = "Material.027";
+
+// floats per vertex while loading: position, texcoord, normal, texture layer (packed for upload)
+constexpr int VERTEX_FLOATS = 9;
+
+// mesh levels of detail: up to LOD_LEVELS levels (the full mesh included), each aiming at half the
+// triangles of the one before with errors up to LOD_MAX_ERROR of the model's size. a level has to
+// save LOD_MIN_SAVING of the triangles of the level before, or generation stops
+constexpr int LOD_LEVELS = 4;
+constexpr float LOD_MAX_ERROR = 0.02f;
+constexpr float LOD_MIN_SAVING = 0.1f;
+
+// a level is drawn while its error covers at most LOD_PIXEL_ERROR pixels on screen; switching to
+// a coarser level waits until it is LOD_HYSTERESIS below that, so levels do not pop back and forth
+constexpr float LOD_PIXEL_ERROR = 1.0f;
+constexpr float LOD_HYSTERESIS = 0.25f;
+
+// GL uploads of loaded assets run at the start of a frame until UPLOAD_BUDGET_MS is spent, the
+// rest waits for the next frame so the loading screen keeps its frame rate
+constexpr double UPLOAD_BUDGET_MS = 4.0;
+
 /**
  * @brief full mesh data
  *
- * contains multiple submeshes and related material info.
+ * all submeshes share one vertex and one index buffer, and all material
+ * textures are layers of one texture array, so the whole mesh is a single
+ * draw. indices are absolute, a submesh range can be drawn on its own too.
+ * simplified levels of detail follow the full mesh in the index buffer and
+ * share its vertices. the geometry only lives on the GPU, CPU copies are
+ * dropped after upload.
  */
 struct Mesh {
+    GLuint vao = 0;                              // vertex array of the shared buffers
+    GLuint vbo = 0;                              // all vertices (PackedVertex)
+    GLuint ebo = 0;                              // all indices
+    GLuint texture_array = 0;                    // material textures, one layer each
+    GLsizei texture_width = 0;                   // size shared by all layers
+    GLsizei texture_height = 0;
+    GLsizei index_count = 0;                     // indices in the element buffer
+    GLenum index_type = GL_UNSIGNED_INT;         // GL_UNSIGNED_SHORT when the vertices fit
     std::vector<SubMesh> submeshes;              // collection of mesh parts
-    std::vector<tinyobj::material_t> materials;  // material info loaded from obj file
+    std::vector<MeshMaterial> materials;         // material names, textures and layers
+    std::vector<MeshLod> lods;                   // whole-mesh index ranges, finest first
+    float radius = 0.0f;                         // bounding sphere radius around the origin
 };
 
 /**
@@ -175,196 +311,494 @@ struct Button {
     std::string label;    // input value this button represents
 };
 
-// global list of buttons in scene
-std::vector<Button> buttons;
+/**
+ * @brief per-frame camera and lighting uniforms
+ *
+ * std140 mirror of the FrameUniforms block in vertex.glsl, fragment.glsl and
+ * skybox.vert. uploaded once per frame into one UBO shared by those programs.
+ */
+struct FrameUniforms {
+    glm::mat4 view;        // camera view matrix
+    glm::mat4 projection;  // camera projection matrix
+    glm::mat4 sky_view;    // view without translation, for the skybox
+    glm::vec4 view_pos;    // camera position (xyz)
+    glm::vec4 light_pos;   // point light position (xyz)
+    glm::vec4 light_color; // light color (rgb)
+};
 
 /**
- * @brief global flags for cubemap loading
+ * @brief global state of the skybox cubemap
  *
- * used by loading thread to signal main thread when cubemap is ready to upload.
+ * the faces are decoded by loader jobs and uploaded by the GL thread.
  */
-std::atomic<bool> cubemap_ready = false;  // true when image data is loaded in memory
-std::atomic<bool> cubemap_loaded = false; // true after OpenGL texture is created
+std::atomic<bool> cubemap_loaded = false; // true after all 6 faces are uploaded
 GLuint cubemap_texture = 0;               // OpenGL texture id for skybox cubemap
-bool show_loading = true;
-std::atomic<int> cubemap_loaded_faces = 0;
 
 /**
- * @brief global storage for cubemap textures
+ * @brief decodes an image file, on a loader thread
+ *
+ * the pixels are shared so the upload task holding them can sit in the
+ * upload queue, they are freed with the last task that refers to them.
  *
- * stores raw image data and info for each face of the cubemap.
- * faces are in this order: right, left, top, bottom, front, back.
+ * @param path image file
+ * @param w receives the width, 0 on failure
+ * @param h receives the height, 0 on failure
+ * @param ch receives the channel count of the file
+ * @param channels channels to convert to, 0 keeps the file's
+ * @return std::shared_ptr<unsigned char> pixels, empty on failure (logged)
  */
-std::vector<unsigned char*> images(6);      // raw pixel data for 6 images
-std::vector<int> widths(6), heights(6);     // image sizes per face
-std::vector<int> channels(6);               // number of channels (e.g. RGB/RGBA)
+std::shared_ptr<unsigned char> decode_image(const std::string& path, int& w, int& h, int& ch, int channels) {
+    TRACE_ZONE("image decode");
+    w = h = ch = 0;
+    std::shared_ptr<unsigned char> pixels(stbi_load(path.c_str(), &w, &h, &ch, channels), stbi_image_free);
+    if (!pixels) std::cerr << "Failed to load: " << path << std::endl;
+    return pixels;
+}
 
 /**
- * @brief loads shader source from file
+ * @brief texture file of each texture array layer of a processed mesh
  *
- * opens a file, reads its contents and returns as a single string.
+ * @param buffers processed mesh with its material table
+ * @param base_path base folder for textures
+ * @return std::vector<std::string> paths in layer order, materials can share one
+ */
+std::vector<std::string> texture_layer_paths(const MeshBuffers& buffers, const std::string& base_path) {
+    std::vector<std::string> layer_paths;
+    for (uint32_t i = 0; i < buffers.materialCount; ++i) {
+        const MeshMaterial& mat = buffers.materials[i];
+        if (mat.layer < 0) continue;
+        if (layer_paths.size() <= static_cast<size_t>(mat.layer)) layer_paths.resize(mat.layer + 1);
+        layer_paths[mat.layer] = base_path + "/" + mat.texture;
+    }
+    return layer_paths;
+}
+
+/**
+ * @brief uploads one decoded layer of a mesh's material texture array
  *
- * @param path path to the shader source file
- * @return std::string content of the shader file
+ * the array is created by the first layer that arrives and all layers share
+ * its size, a layer of another size stays black (as do layers that failed
+ * to decode and are never uploaded).
+ *
+ * @param model mesh owning the texture array, created on the first layer
+ * @param layers number of layers of the array
+ * @param layer layer to fill
+ * @param rgba decoded RGBA pixels
+ * @param w width of the image
+ * @param h height of the image
+ * @param path texture file, for the log
  */
-std::string load_shader_source(const char* path) {
-    std::ifstream file(path);        // open file for reading
-    std::stringstream ss;            // stringstream to collect lines
-    ss << file.rdbuf();              // read entire file into the stream
-    return ss.str();                 // return combined string
+void upload_texture_layer(Mesh& model, size_t layers, size_t layer, const unsigned char* rgba,
+                          int w, int h, const std::string& path) {
+    TRACE_ZONE("texture layer upload");
+    if (!model.texture_array) {
+        model.texture_width = w;
+        model.texture_height = h;
+        glGenTextures(1, &model.texture_array);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, model.texture_array);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, w, h, static_cast<GLsizei>(layers),
+                0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);  // smooth filter
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, model.texture_array);
+    if (w == model.texture_width && h == model.texture_height) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), w, h, 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    } else {
+        std::cerr << "Texture " << path << " is " << w << "x" << h << ", the texture array is "
+                  << model.texture_width << "x" << model.texture_height << std::endl;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
 
 /**
- * @brief compiles and links vertex + fragment shaders
+ * @brief uploads a processed mesh
  *
- * loads shader source from files, compiles them,
- * links them into a shader program and returns the program ID.
+ * the buffers can point straight into a mapped mesh cache file. the material
+ * textures follow layer by layer through upload_texture_layer.
  *
- * @param vertex_path path to vertex shader source
- * @param fragment_path path to fragment shader source
- * @return GLuint compiled and linked OpenGL shader program
+ * @param buffers processed vertices, indices, draw ranges and materials
+ * @return Mesh a mesh object containing the buffers, without textures yet
  */
-GLuint createShaderProgram(const char* vertex_path, const char* fragment_path) {
-
-    // load source code of vertex and fragment shaders
-    std::string v_code = load_shader_source(vertex_path);  // read vertex shader code from file
-    std::string f_code = load_shader_source(fragment_path); // read fragment shader code from file
-    const char* v_shader_code = v_code.c_str();           // convert to C-string for OpenGL
-    const char* f_shader_code = f_code.c_str();
-
-    // create vertex shader and compile it
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);      // create vertex shader object
-    glShaderSource(vertex_shader, 1, &v_shader_code, nullptr);      // attach source
-    glCompileShader(vertex_shader);                               // compile shader
-
-    // create fragment shader and compile it
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);  // create fragment shader object
-    glShaderSource(fragment_shader, 1, &f_shader_code, nullptr);    // attach source
-    glCompileShader(fragment_shader);                             // compile shader
-
-    // link shaders into a single shader program
-    GLuint shader_program = glCreateProgram();                    // create shader program
-    glAttachShader(shader_program, vertex_shader);                 // attach vertex shader
-    glAttachShader(shader_program, fragment_shader);               // attach fragment shader
-    glLinkProgram(shader_program);                                // link program
-
-    // cleanup shaders after linking
-    glDeleteShader(vertex_shader);  // no longer needed
-    glDeleteShader(fragment_shader);
-
-    return shader_program;  // return the program ID
+Mesh upload_mesh(const MeshBuffers& buffers) {
+    TRACE_ZONE("mesh upload");
+    Mesh model;
+    model.materials.assign(buffers.materials, buffers.materials + buffers.materialCount);
+    for (uint32_t i = 0; i < buffers.rangeCount; ++i) {
+        const MeshRange& range = buffers.ranges[i];
+        model.submeshes.push_back({ range.firstIndex, static_cast<GLsizei>(range.indexCount), range.material });
+    }
+
+    model.index_count = static_cast<GLsizei>(buffers.indexCount);
+    model.lods.assign(buffers.lods, buffers.lods + buffers.lodCount);
+    for (uint32_t v = 0; v < buffers.vertexCount; ++v) {
+        const float* p = buffers.vertices[v].position;
+        model.radius = std::max(model.radius, std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+    }
+    model.index_type = buffers.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    // generate the shared OpenGL buffers
+    glGenVertexArrays(1, &model.vao);                     // create vertex array
+    glGenBuffers(1, &model.vbo);                          // create vertex buffer
+    glGenBuffers(1, &model.ebo);                          // create element/index buffer
+
+    glBindVertexArray(model.vao);                         // bind array
+    glBindBuffer(GL_ARRAY_BUFFER, model.vbo);             // bind vertex buffer
+    glBufferData(GL_ARRAY_BUFFER,                         // send vertex data to GPU
+            buffers.vertexCount * sizeof(PackedVertex),
+            buffers.vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.ebo);     // bind index buffer
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,                 // send index data to GPU
+            static_cast<size_t>(buffers.indexCount) * buffers.indexSize,
+            buffers.indices, GL_STATIC_DRAW);
+
+    // enable vertex attributes
+    const GLsizei stride = sizeof(PackedVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+            (void*)offsetof(PackedVertex, position));                                          // pos
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+            (void*)offsetof(PackedVertex, texcoord));                                          // texcoord
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+            (void*)offsetof(PackedVertex, normal));                                            // normal
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(3, 1, GL_SHORT, GL_FALSE, stride,
+            (void*)offsetof(PackedVertex, layer));                                             // texture layer
+    glEnableVertexAttribArray(3);
+
+    glBindVertexArray(0);                                 // unbind
+    return model;
 }
 
 /**
- * @brief loads a .obj model from disk and prepares it for rendering
+ * @brief appends simplified levels of detail to the index buffer
  *
- * loads geometry and materials, generates opengl buffers (vao/vbo/ebo),
- * and loads any textures found in the materials.
+ * every submesh is simplified from the full mesh on its own (in parallel),
+ * so the parts keep their materials, and the results of one level are
+ * stored back to back to draw in one call. a level's error is the largest
+ * of its submeshes and never below the level before.
  *
- * @param obj_path path to the .obj model file
- * @param base_path base folder for textures/materials
- * @return Mesh a mesh object containing geometry, buffers and textures
+ * @param vertices welded vertices, VERTEX_FLOATS floats each
+ * @param indices full mesh indices, the levels are appended
+ * @param ranges submeshes of the full mesh
+ * @param threads threads to simplify on
+ * @return levels of detail, the full mesh first
  */
-Mesh load_obj_model(const std::string& obj_path, const std::string& base_path) {
-    tinyobj::attrib_t attrib;                       // stores all vertex data
-    std::vector<tinyobj::shape_t> shapes;           // stores individual mesh parts
-    std::vector<tinyobj::material_t> materials;     // stores materials and texture info
-    std::string warn, err;                          // capture warnings and errors
-
-    // load the obj model
-    bool ok = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, obj_path.c_str(), base_path.c_str(), true);
-    if (!ok) throw std::runtime_error("Failed to load OBJ: " + err);  // crash if load failed
-
-    // store OpenGL texture ids for each material
-    std::vector<GLuint> texture_IDs(materials.size());
-    for (size_t i = 0; i < materials.size(); ++i) {
-        std::string tex_path = base_path + "/" + materials[i].diffuse_texname;  // full path to texture
-        int w, h, ch;
-        unsigned char* data = stbi_load(tex_path.c_str(), &w, &h, &ch, 0);      // load image
-        if (data) {
-            glGenTextures(1, &texture_IDs[i]);                          // create texture
-            glBindTexture(GL_TEXTURE_2D, texture_IDs[i]);               // bind it
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0,           // send image to GPU
-                    (ch == 4 ? GL_RGBA : GL_RGB), GL_UNSIGNED_BYTE, data);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);  // smooth filter
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            stbi_image_free(data);                                     // free image data
-        } else {
-            std::cerr << "Failed to load: " << tex_path << std::endl;   // log failure
-            texture_IDs[i] = 0;                                         // set to 0 if failed
+std::vector<MeshLod> generate_lods(const std::vector<float>& vertices, std::vector<uint32_t>& indices,
+                                   const std::vector<MeshRange>& ranges, unsigned threads) {
+    TRACE_ZONE("mesh lods");
+    const size_t vertex_count = vertices.size() / VERTEX_FLOATS;
+    std::vector<MeshLod> lods(1);
+    lods[0].indexCount = static_cast<uint32_t>(indices.size());
+
+    // errors are allowed relative to the bounding box diagonal
+    float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (size_t v = 0; v < vertex_count; ++v) {
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], vertices[v * VERTEX_FLOATS + k]);
+            hi[k] = std::max(hi[k], vertices[v * VERTEX_FLOATS + k]);
         }
     }
+    const float size = vertex_count ? std::sqrt((hi[0] - lo[0]) * (hi[0] - lo[0]) + (hi[1] - lo[1]) * (hi[1] - lo[1])
+                                                + (hi[2] - lo[2]) * (hi[2] - lo[2])) : 0.0f;
+
+    std::vector<std::vector<uint32_t>> parts(ranges.size());
+    std::vector<float> errors(ranges.size());
+    for (int level = 1; level < LOD_LEVELS; ++level) {
+        ParallelFor(ranges.size(), [&](size_t r) {
+            const MeshRange& range = ranges[r];
+            size_t target = range.indexCount / 3 / (size_t(1) << level) * 3;
+            parts[r].resize(range.indexCount);
+            parts[r].resize(SimplifyMesh(parts[r].data(), &indices[range.firstIndex], range.indexCount,
+                    vertices.data(), vertex_count, VERTEX_FLOATS, target, LOD_MAX_ERROR * size, &errors[r]));
+        }, threads);
+
+        size_t count = 0;
+        for (const auto& part : parts) count += part.size();
+        if (count > (1.0f - LOD_MIN_SAVING) * lods.back().indexCount) break;
+
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+        lod.indexCount = static_cast<uint32_t>(count);
+        lod.error = std::max(lods.back().error, *std::max_element(errors.begin(), errors.end()));
+        for (const auto& part : parts) indices.insert(indices.end(), part.begin(), part.end());
+        lods.push_back(lod);
+    }
+    return lods;
+}
 
-    Mesh model;  // main mesh we return
+/**
+ * @brief picks the level of detail to draw from the projected error of each level
+ *
+ * the coarsest level whose error covers at most LOD_PIXEL_ERROR pixels is
+ * wanted. a level that got too coarse is left at once, a coarser one is
+ * only taken with LOD_HYSTERESIS to spare.
+ *
+ * @param lods levels of detail, errors ascending
+ * @param current level drawn last frame
+ * @param pixels_per_unit screen pixels one model unit covers at the mesh's nearest point
+ * @return size_t level to draw
+ */
+size_t select_lod(const std::vector<MeshLod>& lods, size_t current, float pixels_per_unit) {
+    size_t lod = std::min(current, lods.size() - 1);
+    while (lod > 0 && lods[lod].error * pixels_per_unit > LOD_PIXEL_ERROR) --lod;
+    while (lod + 1 < lods.size()
+           && lods[lod + 1].error * pixels_per_unit <= LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS)) {
+        ++lod;
+    }
+    return lod;
+}
 
-    // go over each shape (sub-mesh)
-    for (const auto& shape : shapes) {
-        SubMesh sub;  // temporary submesh
-        sub.material_ID = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];  // which material to use
+/**
+ * @brief hash of a .obj file and the .mtl files it references
+ *
+ * @param obj_path path to the .obj model file
+ * @param base_path base folder for materials
+ * @return uint64_t content hash, 0 if a file cannot be read
+ */
+uint64_t mesh_source_hash(const std::string& obj_path, const std::string& base_path) {
+    std::vector<std::string> mtl_files;
+    std::ifstream obj(obj_path);
+    std::string line;
+    while (std::getline(obj, line)) {
+        // read the statement the way ParseObj does: blanks around it and CRLF endings are not part of the name
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t keyword = line.find_first_not_of(" \t");
+        if (keyword == std::string::npos || line.compare(keyword, 6, "mtllib") != 0) continue;
+        size_t separator = keyword + 6;
+        if (separator >= line.size() || (line[separator] != ' ' && line[separator] != '\t')) continue;
+        size_t first = line.find_first_not_of(" \t", separator);
+        if (first == std::string::npos) continue;
+        size_t last = line.find_last_not_of(" \t");
+        mtl_files.push_back(line.substr(first, last - first + 1));
+    }
 
-        // go over all indices in this shape
-        for (const auto& idx : shape.mesh.indices) {
-            float vx = attrib.vertices[3 * idx.vertex_index + 0];  // x
-            float vy = attrib.vertices[3 * idx.vertex_index + 1];  // y
-            float vz = attrib.vertices[3 * idx.vertex_index + 2];  // z
+    uint64_t hash = HashFile(obj_path);
+    for (const std::string& mtl : mtl_files) {
+        if (hash) hash = HashFile(base_path + "/" + mtl, hash);
+    }
+    return hash;
+}
 
-            float tx = 0.0f, ty = 0.0f;
-            if (!attrib.texcoords.empty() && idx.texcoord_index >= 0) {
-                tx = attrib.texcoords[2 * idx.texcoord_index + 0];         // u
-                ty = 1.0f - attrib.texcoords[2 * idx.texcoord_index + 1]; // v (flipped)
-            }
+/**
+ * @brief processed model waiting for upload on the GL thread
+ *
+ * owns whatever the buffers point into: the mapped mesh cache, or the
+ * vectors a fresh processing run filled.
+ */
+struct MeshData {
+    MeshCache cache;                          // mapped cache file, when loaded from it
+    std::vector<PackedVertex> vertices;       // quantized vertices
+    std::vector<uint32_t> indices;            // 32-bit indices
+    std::vector<uint16_t> short_indices;      // 16-bit copy when the vertices fit
+    std::vector<MeshRange> ranges;            // index range per shape
+    std::vector<MeshLod> lods;                // whole-mesh index range per level of detail
+    std::vector<MeshMaterial> materials;      // material table
+    MeshBuffers buffers;                      // what upload_mesh reads
+};
 
-            float nx = 0.0f, ny = 0.0f, nz = 0.0f;
-            if (!attrib.normals.empty() && idx.normal_index >= 0) {
-                nx = attrib.normals[3 * idx.normal_index + 0];  // normal x
-                ny = attrib.normals[3 * idx.normal_index + 1];  // normal y
-                nz = attrib.normals[3 * idx.normal_index + 2];  // normal z
-            }
+/**
+ * @brief loads a .obj model from disk and prepares it for rendering
+ *
+ * CPU only, runs on a loader thread: the result is handed to upload_mesh on
+ * the GL thread. all shapes are merged into one vertex and index buffer and
+ * each vertex carries the texture array layer of its material, so one draw
+ * call renders every material. identical vertices are welded, triangles and
+ * vertices reordered for the vertex cache and fetch locality, and vertices
+ * quantized.
+ *
+ * the .obj is parsed in parallel line-aligned chunks (ParseObj), then the
+ * shapes are expanded into vertices and cache-optimized in parallel too, so
+ * large models load in time that scales with the core count.
+ *
+ * the processed buffers are saved to a binary mesh cache keyed by the hash
+ * of the source files. later launches map that file and upload it directly,
+ * without parsing the .obj.
+ *
+ * @param obj_path path to the .obj model file
+ * @param base_path base folder for textures/materials
+ * @return processed buffers ready for upload_mesh
+ */
+std::unique_ptr<MeshData> process_obj_model(const std::string& obj_path, const std::string& base_path) {
+    TRACE_ZONE("process_obj_model");
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&start] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
 
-            // push full vertex into buffer
-            sub.vertices.insert(sub.vertices.end(), { vx, vy, vz, tx, ty, nx, ny, nz });
+    auto mesh = std::make_unique<MeshData>();
+    uint64_t source_hash = mesh_source_hash(obj_path, base_path);
+    std::string cache_path = source_hash ? MeshCache::Path(source_hash) : std::string();
+    bool cached;
+    {
+        TRACE_ZONE("mesh cache open");
+        cached = !cache_path.empty() && mesh->cache.Open(cache_path, source_hash);
+    }
+    if (cached) {
+        mesh->buffers = mesh->cache.Buffers();
+        std::cout << "Mesh " << obj_path << ": loaded from " << cache_path << " in " << elapsed_ms() << " ms" << std::endl;
+        return mesh;
+    }
 
-            // push index
-            sub.indices.push_back(sub.indices.size());
+    const unsigned threads = LoadThreadCount();
+    ObjData obj;
+    std::string err;
+    {
+        TRACE_ZONE("ParseObj");
+        if (!LoadObjFile(obj_path, obj, threads, &err)) throw std::runtime_error("Failed to load OBJ: " + err);
+    }
+    double parse_ms = elapsed_ms();
+
+    // materials of every mtllib, ids in file order
+    std::vector<tinyobj::material_t> materials;
+    std::map<std::string, int> material_ids;
+    for (const std::string& lib : obj.materialLibraries) {
+        std::ifstream mtl(base_path + "/" + lib);
+        if (!mtl) {
+            std::cerr << "Failed to load material library: " << lib << std::endl;
+            continue;
         }
+        std::string warn;
+        tinyobj::LoadMtl(&material_ids, &materials, &mtl, &warn, &err);
+    }
 
-        // generate OpenGL buffers for this submesh
-        glGenVertexArrays(1, &sub.vao);                       // create vertex array
-        glGenBuffers(1, &sub.vbo);                            // create vertex buffer
-        glGenBuffers(1, &sub.ebo);                            // create element/index buffer
-
-        glBindVertexArray(sub.vao);                           // bind array
-        glBindBuffer(GL_ARRAY_BUFFER, sub.vbo);               // bind vertex buffer
-        glBufferData(GL_ARRAY_BUFFER,                        // send vertex data to GPU
-                sub.vertices.size() * sizeof(float),
-                sub.vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sub.ebo);       // bind index buffer
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,                // send index data to GPU
-                sub.indices.size() * sizeof(unsigned int),
-                sub.indices.data(), GL_STATIC_DRAW);
+    // material table: one texture array layer per distinct texture
+    std::vector<MeshMaterial>& table = mesh->materials;
+    table.resize(materials.size());
+    std::vector<std::string> layer_textures;
+    for (size_t i = 0; i < materials.size(); ++i) {
+        MeshMaterial& mat = table[i];
+        std::snprintf(mat.name, sizeof(mat.name), "%s", materials[i].name.c_str());
+        std::snprintf(mat.texture, sizeof(mat.texture), "%s", materials[i].diffuse_texname.c_str());
+        if (materials[i].name == SCREEN_MATERIAL) {
+            mat.layer = static_cast<int32_t>(SCREEN_LAYER); // sampled from the offscreen display texture
+        } else if (!materials[i].diffuse_texname.empty()) {
+            auto it = std::find(layer_textures.begin(), layer_textures.end(), materials[i].diffuse_texname);
+            mat.layer = static_cast<int32_t>(it - layer_textures.begin());
+            if (it == layer_textures.end()) layer_textures.push_back(materials[i].diffuse_texname);
+        }
+    }
 
-        // enable vertex attributes
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);             // pos
-        glEnableVertexAttribArray(0);
+    // one range per shape; the parser keeps shapes back to back, so corner offsets are index offsets
+    std::vector<MeshRange>& ranges = mesh->ranges;
+    std::vector<float> shape_layers;
+    for (const ObjShape& shape : obj.shapes) {
+        MeshRange range;
+        auto id = material_ids.find(shape.material);
+        range.material = id == material_ids.end() ? -1 : id->second;
+        range.firstIndex = shape.firstIndex;
+        range.indexCount = shape.indexCount;
+        ranges.push_back(range);
+        shape_layers.push_back(range.material >= 0 ? static_cast<float>(table[range.material].layer) : NO_TEXTURE_LAYER);
+    }
 
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // texcoord
-        glEnableVertexAttribArray(1);
+    // expanded geometry, one vertex per index until it is welded. shapes are cut
+    // into blocks, so one huge shape still spreads over every thread
+    const uint32_t expand_block = 1 << 16;
+    std::vector<std::pair<uint32_t, uint32_t>> blocks; // (shape, first corner)
+    for (size_t s = 0; s < ranges.size(); ++s) {
+        for (uint32_t first = 0; first < ranges[s].indexCount; first += expand_block) {
+            blocks.emplace_back(static_cast<uint32_t>(s), ranges[s].firstIndex + first);
+        }
+    }
+    std::vector<float> vertices(obj.corners.size() * VERTEX_FLOATS);
+    std::vector<uint32_t>& indices = mesh->indices;
+    indices.resize(obj.corners.size());
+    {
+        TRACE_ZONE("mesh expand");
+        ParallelFor(blocks.size(), [&](size_t b) {
+            const auto [shape, first] = blocks[b];
+            const MeshRange& range = ranges[shape];
+            const uint32_t last = std::min(first + expand_block, range.firstIndex + range.indexCount);
+            for (uint32_t i = first; i < last; ++i) {
+                const ObjCorner& idx = obj.corners[i];
+                float* v = &vertices[static_cast<size_t>(i) * VERTEX_FLOATS];
+                std::copy_n(&obj.positions[3 * static_cast<size_t>(idx.vertex)], 3, v);  // x, y, z
+
+                v[3] = v[4] = 0.0f;
+                if (idx.texcoord >= 0) {
+                    v[3] = obj.texcoords[2 * static_cast<size_t>(idx.texcoord) + 0];         // u
+                    v[4] = 1.0f - obj.texcoords[2 * static_cast<size_t>(idx.texcoord) + 1];  // v (flipped)
+                }
 
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float))); // normal
-        glEnableVertexAttribArray(2);
+                v[5] = v[6] = v[7] = 0.0f;
+                if (idx.normal >= 0) std::copy_n(&obj.normals[3 * static_cast<size_t>(idx.normal)], 3, v + 5);
 
-        glBindVertexArray(0);                                 // unbind
-        model.submeshes.push_back(sub);                       // add to model
+                v[8] = shape_layers[shape];
+                indices[i] = i;  // indices are absolute so the whole mesh is one draw
+            }
+        }, threads);
+    }
+    obj = ObjData{};  // the parsed file is no longer needed
+
+    // share identical vertices, simplify, then order for the post-transform cache and for fetching
+    size_t expanded_count = vertices.size() / VERTEX_FLOATS;
+    size_t vertex_count;
+    float acmr_welded, acmr_optimized;
+    {
+        TRACE_ZONE("mesh weld");
+        vertex_count = WeldVertices(vertices, VERTEX_FLOATS, indices);
+        acmr_welded = AverageCacheMissRatio(indices.data(), indices.size());
+    }
+    std::vector<MeshLod>& lods = mesh->lods;
+    lods = generate_lods(vertices, indices, ranges, threads);
+    {
+        TRACE_ZONE("mesh optimize");
+        // per submesh of the full mesh, so its ranges stay valid, and per coarser level; none overlap
+        std::vector<std::pair<uint32_t, uint32_t>> spans; // (first index, index count)
+        for (const MeshRange& range : ranges) spans.emplace_back(range.firstIndex, range.indexCount);
+        for (size_t l = 1; l < lods.size(); ++l) spans.emplace_back(lods[l].firstIndex, lods[l].indexCount);
+        ParallelFor(spans.size(), [&](size_t s) {
+            OptimizeVertexCache(indices.data() + spans[s].first, spans[s].second, vertex_count);
+        }, threads);
+        acmr_optimized = AverageCacheMissRatio(indices.data(), lods[0].indexCount);
+        OptimizeVertexFetch(vertices, VERTEX_FLOATS, indices);
+        vertex_count = vertices.size() / VERTEX_FLOATS;
     }
 
-    // store texture ID inside material structure (uses unused 'illum' field)
-    for (size_t i = 0; i < texture_IDs.size(); ++i) {
-        materials[i].illum = texture_IDs[i];  // reuse field to store texture handle
+    // half float texcoords, 10-10-10-2 normals, 16-bit indices when they fit
+    std::vector<PackedVertex>& packed = mesh->vertices;
+    packed.resize(vertex_count);
+    ParallelFor((vertex_count + expand_block - 1) / expand_block, [&](size_t b) {
+        size_t last = std::min(vertex_count, (b + 1) * expand_block);
+        for (size_t v = b * expand_block; v < last; ++v) packed[v] = PackVertex(&vertices[v * VERTEX_FLOATS]);
+    }, threads);
+    if (vertex_count <= 0x10000) mesh->short_indices.assign(indices.begin(), indices.end());
+
+    MeshBuffers& buffers = mesh->buffers;
+    buffers.vertices = packed.data();
+    buffers.vertexCount = static_cast<uint32_t>(packed.size());
+    buffers.indices = mesh->short_indices.empty() ? static_cast<const void*>(indices.data()) : mesh->short_indices.data();
+    buffers.indexCount = static_cast<uint32_t>(indices.size());
+    buffers.indexSize = mesh->short_indices.empty() ? 4 : 2;
+    buffers.ranges = ranges.data();
+    buffers.rangeCount = static_cast<uint32_t>(ranges.size());
+    buffers.lods = lods.data();
+    buffers.lodCount = static_cast<uint32_t>(lods.size());
+    buffers.materials = table.data();
+    buffers.materialCount = static_cast<uint32_t>(table.size());
+
+    if (!cache_path.empty() && !MeshCache::Write(cache_path, source_hash, buffers)) {
+        std::cerr << "Failed to write mesh cache " << cache_path << std::endl;
     }
-    model.materials = materials;  // assign materials
 
-    return model;  // return the complete mesh
+    // what the unshared 9-float vertices and 32-bit indices would take on the GPU
+    size_t expanded_bytes = expanded_count * (VERTEX_FLOATS * sizeof(float) + sizeof(uint32_t));
+    size_t packed_bytes = packed.size() * sizeof(PackedVertex) + static_cast<size_t>(lods[0].indexCount) * buffers.indexSize;
+    std::cout << "Mesh " << obj_path << ": " << expanded_count << " -> " << vertex_count << " vertices, ACMR "
+              << acmr_welded << " -> " << acmr_optimized << ", GPU " << expanded_bytes / 1024 << " KB -> "
+              << packed_bytes / 1024 << " KB, LOD triangles";
+    for (const MeshLod& lod : lods) std::cout << ' ' << lod.indexCount / 3 << " (error " << lod.error << ')';
+    std::cout << ", parsed in " << parse_ms << " ms, processed in " << elapsed_ms() << " ms on "
+              << threads << " threads" << std::endl;
+
+    return mesh;
 }
 
 /**
@@ -386,7 +820,8 @@ bool isOp(char c){
  * @return Evaluated result as double.
  */
 double calculate(const std::string& expr){
-	std::cout << "evaluating expression: " << expr << std::endl;
+	TRACE_ZONE("calculate");
+	TRACE_INSTANT("evaluating expression", expr.c_str());
 	std::vector<double> nums;
     std::string ops = "";
 	std::string num = "";
@@ -395,18 +830,20 @@ double calculate(const std::string& expr){
 	// split the expression into numbers and operations
     for(size_t i = 0; i < expr.size(); i++){
         if(isOp(expr[i])){
+			// character before the operation, none at the start of the expression
+			const char prev = i > 0 ? expr[i-1] : '\0';
 			// handle when - follows a different operation
-            if(expr[i] == '-' && (isOp(expr[i-1]) || i == 0) && expr[i-1] != '!'){
+            if(expr[i] == '-' && (i == 0 || isOp(prev)) && prev != '!'){
                 continue;
             }
 			// allow all operations to directly folow factorial
-            else if(expr[i-1] == '!'){
+            else if(prev == '!'){
                 ops += expr[i];
                 num_start = i+1;
                 continue;
             }
 			// handle when the index of the root isn't given (defaults to 2 for the square root)
-			else if(expr[i] == 'r' && (isOp(expr[i-1]) || i == 0)){
+			else if(expr[i] == 'r' && (i == 0 || isOp(prev))){
 				nums.push_back(2);
 				ops += expr[i];
 				num_start = i+1;
@@ -544,7 +981,7 @@ double calculate(const std::string& expr){
         }
     }
 
-	std::cout << "Evaluated expression: " << nums[0] << std::endl;
+	TRACE_INSTANT("evaluated expression", std::to_string(nums[0]).c_str());
 
     return nums[0];
 }
@@ -651,21 +1088,14 @@ float skyboxVertices[] = {
 };
 
 /**
- * @brief handles mouse scroll to zoom camera
- *
- * scroll up = zoom in, scroll down = zoom out
- * clamps zoom range between 2.0 and 30.0
+ * @brief glfw callback for mouse scroll, zooms the camera (see apply_input)
  *
  * @param window pointer to glfw window
  * @param xoffset scroll on x (unused)
  * @param yoffset scroll on y (used for zoom)
  */
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    target_radius -= yoffset * 0.5f; // zoom by changing target camera radius
-
-    // clamp to min and max zoom
-    if (target_radius < 2.0f) target_radius = 2.0f;
-    if (target_radius > 30.0f) target_radius = 30.0f;
+    queue_input(InputEventType::Scroll, 0, 0, 0, xoffset, yoffset);
 }
 
 
@@ -699,6 +1129,8 @@ void process_input(const std::string& inputLabel) {
         return;
     }
 
+    ++display_version; // the screen texture is redrawn on the next frame
+
 	if(full_expression.empty()){
 		full_expression = "0";
 	}
@@ -948,11 +1380,7 @@ void process_input(const std::string& inputLabel) {
 
 
 /**
- * @brief glfw callback for special key input
- *
- * handles non-character keys like escape, enter, or R
- * sends mapped string to process_input
- * leaves regular characters for character_callback
+ * @brief glfw callback for special key input, queued for the simulation thread
  *
  * @param window glfw window context
  * @param key key code pressed
@@ -961,69 +1389,602 @@ void process_input(const std::string& inputLabel) {
  * @param mods modifier keys (shift/ctrl etc.)
  */
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-    // handle key only if pressed or held down
-    if (action == GLFW_PRESS || action == GLFW_REPEAT) {
-        switch (key) {
-            case GLFW_KEY_BACKSPACE: process_input("CE"); break;  // backspace = CE
-            case GLFW_KEY_DELETE:    process_input("C");  break;  // delete = C
-            case GLFW_KEY_ENTER:     process_input("=");  break;
-            case GLFW_KEY_R:         process_input("sqrt"); break;
-            case GLFW_KEY_6:		 if(mods == GLFW_MOD_SHIFT) process_input("a^n"); break;
-			case GLFW_KEY_1:		 if(mods == GLFW_MOD_SHIFT) process_input("!"); break;
-            case GLFW_KEY_P:         process_input("pi"); break;
-            case GLFW_KEY_E:         process_input("e"); break;
-            default: break;
-        }
-    }
-
+    queue_input(InputEventType::Key, key, action, mods);
 }
 
 /**
- * @brief glfw callback for character input
- *
- * handles typed characters like numbers and operators
- * filters to allowed symbols and sends as string to process_input
+ * @brief glfw callback for character input, queued for the simulation thread
  *
  * @param window glfw window context
  * @param codepoint unicode value of typed character
  */
 void character_callback(GLFWwindow* window, unsigned int codepoint) {
-    char c = static_cast<char>(codepoint); // convert to ascii char
+    queue_input(InputEventType::Char, static_cast<int>(codepoint));
+}
 
-    // only allow valid typed characters
-    if (std::isdigit(c) || c == '.' || c == '+' || c == '-' || c == '*' || c == '/' || c == '%') {
-        process_input(std::string(1, c)); // send one-char string to input
+/**
+ * @brief glfw callback for mouse buttons, queued for the simulation thread
+ */
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    queue_input(InputEventType::MouseButton, button, action, mods);
+}
+
+/**
+ * @brief glfw callback for cursor movement, queued for the simulation thread
+ */
+void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos) {
+    queue_input(InputEventType::CursorPos, 0, 0, 0, xpos, ypos);
+}
+
+/**
+ * @brief glfw callback for when the window contents need to be redrawn (expose, resize)
+ */
+void window_refresh_callback(GLFWwindow* window) {
+    redraw_requested = true;
+}
+
+/**
+ * @brief converts a per-frame smoothing factor tuned at 60 fps to a frame of dt seconds
+ *
+ * x += (target - x) * f once per 60 fps frame is the same exponential decay as
+ * x += (target - x) * (1 - (1 - f)^(dt * 60)), so easing no longer depends on frame rate.
+ *
+ * @param factor_at_60fps fraction of the remaining distance covered per 60 fps frame
+ * @param dt frame time in seconds
+ * @return fraction of the remaining distance to cover this frame
+ */
+float ease_factor(float factor_at_60fps, float dt) {
+    return 1.0f - std::pow(1.0f - factor_at_60fps, dt * 60.0f);
+}
+
+
+// =========================
+//     simulation thread
+// =========================
+
+constexpr double SIM_TICK_RATE = 120.0;  // simulation ticks per second
+constexpr float SETTLE_EPSILON = 0.01f;  // camera closer than this to its target counts as settled
+
+/**
+ * @brief camera and ui state owned by the simulation thread
+ */
+struct SimState {
+    float yaw = 0.0f, pitch = 0.0f;               // current camera angles
+    float target_yaw = 0.0f, target_pitch = 0.0f; // desired angles
+    float radius = 5.0f, target_radius = 5.0f;    // camera distance, eased towards the target
+    double last_x = 0.0, last_y = 0.0;            // cursor position at the previous drag tick
+    bool dragging = false;                        // middle mouse drag in progress
+    bool was_pressed = false;                     // left button debounce for the 3d buttons
+    bool was_pressed_2d = false;                  // left button debounce for '?' / 'X'
+    bool show_help_overlay = false;
+    long tick = 0;                                // ticks run so far
+
+    // last published values, a tick that changes none of them publishes nothing
+    glm::mat4 published_view = glm::mat4(0.0f);
+    unsigned long published_version = 0;
+    bool published_help = false;
+};
+
+/**
+ * @brief everything the render loop needs from one simulation tick
+ */
+struct SimSnapshot {
+    glm::mat4 view = glm::mat4(1.0f);        // camera view matrix
+    glm::mat4 projection = glm::mat4(1.0f);  // camera projection matrix
+    glm::vec3 camera_pos = glm::vec3(0.0f);  // camera position in world space
+    std::string full_expression;             // top line of the display
+    std::string display_value;               // bottom line of the display
+    unsigned long display_version = ~0ul;    // display_version the strings belong to
+    bool show_help_overlay = false;
+    long tick = -1;                          // simulation tick that produced the snapshot
+};
+
+// latest simulation state for the render loop, exchanged without locks
+TripleBuffer<SimSnapshot> sim_snapshots;
+
+// framebuffer size for picking, written by the render loop
+std::atomic<int> framebuffer_width = 800, framebuffer_height = 600;
+
+/**
+ * @brief applies one input event on the simulation thread
+ *
+ * keys are mapped to calculator input (characters are left to the char
+ * event), the mouse updates the tracked button/cursor state and scrolling
+ * zooms the camera, clamped between 2.0 and 30.0
+ */
+void apply_input(const InputEvent& event, SimState& state) {
+    switch (event.type) {
+        case InputEventType::Key:
+            // handle key only if pressed or held down
+            if (event.action != GLFW_PRESS && event.action != GLFW_REPEAT) break;
+            switch (event.code) {
+                case GLFW_KEY_BACKSPACE: process_input("CE"); break;  // backspace = CE
+                case GLFW_KEY_DELETE:    process_input("C");  break;  // delete = C
+                case GLFW_KEY_ENTER:     process_input("=");  break;
+                case GLFW_KEY_R:         process_input("sqrt"); break;
+                case GLFW_KEY_6:         if (event.mods == GLFW_MOD_SHIFT) process_input("a^n"); break;
+                case GLFW_KEY_1:         if (event.mods == GLFW_MOD_SHIFT) process_input("!"); break;
+                case GLFW_KEY_P:         process_input("pi"); break;
+                case GLFW_KEY_E:         process_input("e"); break;
+                case GLFW_KEY_F3:        if (event.action == GLFW_PRESS) show_perf_hud = !show_perf_hud; break;
+                case GLFW_KEY_F4:        if (event.action == GLFW_PRESS) perf_capture_toggled = true; break;
+                default: break;
+            }
+            break;
+
+        case InputEventType::Char: {
+            char c = static_cast<char>(event.code); // convert to ascii char
+
+            // only allow valid typed characters
+            if (std::isdigit(c) || c == '.' || c == '+' || c == '-' || c == '*' || c == '/' || c == '%') {
+                process_input(std::string(1, c)); // send one-char string to input
+            }
+            break;
+        }
+
+        case InputEventType::MouseButton:
+            if (event.code < 0 || event.code > GLFW_MOUSE_BUTTON_LAST) break;
+            mouse.down[event.code] = event.action == GLFW_PRESS;
+            if (event.action == GLFW_RELEASE) mouse.sticky[event.code] = true;
+            break;
+
+        case InputEventType::CursorPos:
+            mouse.x = event.x;
+            mouse.y = event.y;
+            break;
+
+        case InputEventType::Scroll:
+            state.target_radius -= event.y * 0.5f; // zoom by changing target camera radius
+
+            // clamp to min and max zoom
+            if (state.target_radius < 2.0f) state.target_radius = 2.0f;
+            if (state.target_radius > 30.0f) state.target_radius = 30.0f;
+            break;
+
+        case InputEventType::Tick:
+            break;
+    }
+}
+
+/**
+ * @brief advances camera and ui by one tick and publishes a snapshot if anything changed
+ *
+ * rotates the camera while the middle button drags, eases angles and zoom,
+ * picks 3d calculator buttons and the 2d help button on left clicks, then
+ * hands the result to the render loop through sim_snapshots
+ *
+ * @param state simulation state
+ * @param buttons clickable calculator buttons
+ * @param dt tick length in seconds
+ * @param force publish even if nothing changed (lockstep benchmark/replay)
+ * @return true while the camera is still moving
+ */
+bool sim_update(SimState& state, const std::vector<Button>& buttons, float dt, bool force) {
+    // =================
+    //       input
+    // =================
+
+    // check if middle mouse button is held
+    if (mouse_button(GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS) {
+
+        // if this is the first tick of dragging, store cursor position
+        if (!state.dragging) {
+            cursor_pos(&state.last_x, &state.last_y);
+            state.dragging = true;
+        } else {
+            // get current cursor position
+            double xpos, ypos;
+            cursor_pos(&xpos, &ypos);
+
+            // calculate cursor movement delta
+            double dx = xpos - state.last_x;
+            double dy = ypos - state.last_y;
+
+            // rotate view based on cursor movement
+            state.target_yaw   -= dx * 0.3f;
+            state.target_pitch += dy * 0.3f;
+
+            // clamp pitch and yaw
+            if (state.target_yaw > 89.0f) state.target_yaw = 89.0f;
+            if (state.target_pitch < -89.0f) state.target_pitch = -89.0f;
+
+            state.last_x = xpos;
+            state.last_y = ypos;
+        }
+
+    } else {
+        // if not dragging, smooth out motion (targets lose 25% per 60 fps frame)
+        state.dragging = false;
+        float decay = 1.0f - ease_factor(0.25f, dt);
+        state.target_yaw   *= decay;
+        state.target_pitch *= decay;
     }
+
+    // smooth interpolation of camera rotation
+    float camera_ease = ease_factor(0.1f, dt);
+    state.yaw   += (state.target_yaw - state.yaw) * camera_ease;
+    state.pitch += (state.target_pitch - state.pitch) * camera_ease;
+
+    // =================
+    //    camera setup
+    // =================
+
+    // create camera direction vector based on yaw and pitch
+    glm::vec3 direction;
+    direction.x = cos(glm::radians(state.pitch)) * sin(glm::radians(state.yaw));
+    direction.y = sin(glm::radians(state.pitch));
+    direction.z = cos(glm::radians(state.pitch)) * cos(glm::radians(state.yaw));
+
+    // set camera position by offsetting from origin
+    glm::vec3 camera_pos = direction * state.radius;
+
+    // create view and projection matrices
+    glm::mat4 view = glm::lookAt(camera_pos, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 75.0f);
+
+    // smooth zooming (camera distance) using interpolation
+    state.radius += (state.target_radius - state.radius) * ease_factor(0.1f, dt);
+
+    int width = framebuffer_width, height = framebuffer_height;
+
+    // handle mouse clicks with debounce (one click per press)
+    // check if left mouse is pressed and wasn't pressed before
+    if (mouse_button(GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !state.was_pressed) {
+        TRACE_ZONE("button picking");
+        state.was_pressed = true; // mark press to avoid spamming
+
+        double mx, my;
+        cursor_pos(&mx, &my); // get mouse screen coords
+
+        // convert screen to normalized device coordinates (-1 to 1)
+        float ndc_x = 2.0f * mx / width - 1.0f;
+        float ndc_y = 1.0f - 2.0f * my / height;
+        glm::vec4 ray_clip(ndc_x, ndc_y, -1.0f, 1.0f); // ray in clip space
+
+        // convert ray to eye space
+        glm::vec4 ray_eye = glm::inverse(projection) * ray_clip;
+        ray_eye = glm::vec4(ray_eye.x, ray_eye.y, -1.0f, 0.0f); // set direction
+
+        // convert ray to world space
+        glm::vec3 ray_world = glm::vec3(glm::inverse(view) * ray_eye);
+        ray_world = glm::normalize(ray_world); // make it unit vector
+
+        // check ray collision with each button
+        for (const auto& btn : buttons) {
+            // direction to button from camera
+            glm::vec3 toButton = (btn.position * 10.0f - camera_pos);
+
+            // t = projected distance along ray
+            float t = glm::dot(toButton, ray_world);
+            if (t < 0.0f) continue; // ignore buttons behind camera
+
+            // point on ray closest to button
+            glm::vec3 closest = camera_pos + ray_world * t;
+
+            // distance from that point to button center
+            float distance = glm::length(closest - btn.position * 10.0f);
+
+            // if within button radius, it's a hit
+            if (distance < btn.size * 15.0f) {
+                process_input(btn.label); // process the button label
+            }
+        }
+
+    } else if (mouse_button(GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
+        state.was_pressed = false; // reset press state on release
+    }
+
+    // '?' and 'X' share one spot in the top-left corner
+    float buttonX = 20.0f;
+    float buttonY = height - 80.0f;
+
+    double mouseX, mouseY;
+    cursor_pos(&mouseX, &mouseY);
+    float flippedY = height - mouseY; // flip Y to OpenGL coordinates
+
+    if (mouse_button(GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !state.was_pressed_2d) {
+        state.was_pressed_2d = true;
+
+        if (mouseX >= buttonX - 10 && mouseX <= buttonX + 40 &&
+                flippedY >= buttonY - 10 && flippedY <= buttonY + 40) {
+            // Click on 'X' closes, click on '?' opens
+            state.show_help_overlay = !state.show_help_overlay;
+            std::cout << (state.show_help_overlay ? "Toggled Help: ON" : "Help closed via X") << std::endl;
+        }
+    } else if (mouse_button(GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
+        state.was_pressed_2d = false;
+    }
+
+    // =================
+    //      publish
+    // =================
+
+    if (force || view != state.published_view || display_version != state.published_version
+            || state.show_help_overlay != state.published_help) {
+        SimSnapshot& snapshot = sim_snapshots.Back();
+        snapshot.view = view;
+        snapshot.projection = projection;
+        snapshot.camera_pos = camera_pos;
+        if (snapshot.display_version != display_version) {
+            // slots come back two publishes later, copy the strings only if they are stale
+            snapshot.full_expression.assign(full_expression);
+            snapshot.display_value.assign((!current_input.empty() && !just_evaluated) ? current_input : current_value);
+            snapshot.display_version = display_version;
+        }
+        snapshot.show_help_overlay = state.show_help_overlay;
+        snapshot.tick = state.tick;
+        sim_snapshots.Publish();
+        glfwPostEmptyEvent(); // wake the render loop if it is waiting for events
+
+        state.published_view = view;
+        state.published_version = display_version;
+        state.published_help = state.show_help_overlay;
+    }
+
+    // keep ticking while a drag is active or the camera eases
+    return state.dragging
+        || std::fabs(state.target_yaw - state.yaw) > SETTLE_EPSILON || std::fabs(state.target_pitch - state.pitch) > SETTLE_EPSILON
+        || std::fabs(state.target_yaw) > SETTLE_EPSILON || std::fabs(state.target_pitch) > SETTLE_EPSILON
+        || std::fabs(state.target_radius - state.radius) > SETTLE_EPSILON * 0.1f;
 }
 
 
+/**
+ * @brief evaluates expressions from stdin without opening a window
+ *
+ * reads one expression per line, runs it through calculate()
+ * and prints the result. used as training workload for pgo builds.
+ *
+ * @return Exit code (0 == success).
+ */
+int run_eval_mode() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) continue;
+        try {
+            std::cout << calculate(line) << std::endl;
+        } catch (...) {
+            std::cout << "ERR" << std::endl;
+        }
+    }
+    return 0;
+}
+
 
 /**
  * @brief Entry point of the application.
  *
  * Initialize the window, OpenGL context, loads resources
  * and runs the main render loop + logic.
+ * `--eval` skips the gui and evaluates expressions from stdin.
+ * `--bench [frames] [--bench-png file]` renders a scripted scene offscreen
+ * and reports frame-time percentiles (see Benchmark).
+ * `--record file` saves the session's input, `--replay file [--fast] [--capture csv]`
+ * plays it back in real time (or as fast as possible) with an optional perf capture.
  *
+ * @param argc argument count
+ * @param argv argument values
  * @return Exit code (0 == success).
  */
-int main() {
+int main(int argc, char** argv) {
+
+    if (argc > 1 && std::string(argv[1]) == "--eval") {
+        return run_eval_mode();
+    }
+
+    std::optional<Benchmark> bench;
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        int frames = 600;
+        std::string png_path;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--bench-png" && i + 1 < argc) png_path = argv[++i];
+            else frames = std::max(1, std::atoi(argv[i]));
+        }
+        bench.emplace(frames, png_path);
+    }
+
+    std::string record_path, replay_path, replay_capture;
+    bool replay_fast = false;
+    if (argc > 2 && std::string(argv[1]) == "--record") {
+        record_path = argv[2];
+    }
+    if (argc > 2 && std::string(argv[1]) == "--replay") {
+        replay_path = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--fast") replay_fast = true;
+            else if (arg == "--capture" && i + 1 < argc) replay_capture = argv[++i];
+        }
+        if (!input_recorder.StartReplay(replay_path)) return -1;
+    }
+    const bool replaying = input_recorder.GetMode() == InputRecorder::Mode::Replay;
 
     // print to confirm launch
     std::cout << "OpenGL Scene starting..." << std::endl;
+    TRACE_THREAD_NAME("main");
+
+    // time to the first interactive frame is measured from here
+    const auto startup_begin = std::chrono::steady_clock::now();
+    auto startup_ms = [&startup_begin] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_begin).count();
+    };
+
+    // assets load on a job system while the window and the GL context come up:
+    // jobs decode and process, the GL work of each asset is queued for the
+    // render loop, which runs it under a per-frame time budget. every asset
+    // counts two progress steps, loaded and uploaded
+    UploadQueue uploads;
+    LoadProgress load_progress;
+    std::atomic<bool> events_ready = false; // glfw is up, loader threads may wake the render loop
+    auto upload = [&](std::function<void()> task) {
+        uploads.Push(std::move(task));
+        if (events_ready) glfwPostEmptyEvent(); // wake the loading screen
+    };
+
+    // everything the jobs and their uploads refer to is declared before the job
+    // system: its destructor stops the workers, so on every return path they
+    // are gone before anything they use
+    const std::string faces[6] = {
+        pather("textures/skybox/px.jpg"), // right
+        pather("textures/skybox/nx.jpg"), // left
+        pather("textures/skybox/py.jpg"), // top
+        pather("textures/skybox/ny.jpg"), // bottom
+        pather("textures/skybox/pz.jpg"), // front
+        pather("textures/skybox/nz.jpg")  // back
+    };
+    int cubemap_faces_uploaded = 0;
+    Mesh calculator;
+    JobSystem jobs;
+
+    // skybox: the six faces decode in parallel, the first upload creates the cube texture
+    for (int i = 0; i < 6; ++i) {
+        load_progress.Add(2);
+        jobs.Submit([&, i] {
+            int w, h, ch;
+            std::shared_ptr<unsigned char> pixels = decode_image(faces[i], w, h, ch, 3);
+            load_progress.Complete();
+            upload([&, i, w, h, pixels] {
+                TRACE_ZONE("cubemap face upload");
+                if (!cubemap_texture) {
+                    glGenTextures(1, &cubemap_texture); // generate texture id
+                    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_texture);
+                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+                }
+                glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_texture);
+                if (pixels) {
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
+                            w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.get());
+                }
+                if (++cubemap_faces_uploaded == 6) cubemap_loaded = true;
+                load_progress.Complete();
+            });
+        });
+    }
+
+    // calculator 3d model (.obj) and its materials: processed by a job, then
+    // the mesh uploads while the texture array layers decode in parallel
+    load_progress.Add(2);
+    jobs.Submit([&] {
+        std::shared_ptr<MeshData> mesh;
+        try {
+            mesh = process_obj_model(pather("objects/calc.obj"), pather("objects/"));
+        } catch (...) {
+            // rethrown on the GL thread: the app cannot run without its model
+            load_progress.Complete();
+            upload([&, error = std::current_exception()] {
+                load_progress.Complete();
+                std::rethrow_exception(error);
+            });
+            return;
+        }
+        const std::vector<std::string> layer_paths = texture_layer_paths(mesh->buffers, pather("objects/"));
+        load_progress.Add(2 * static_cast<unsigned>(layer_paths.size())); // before this job's step completes
+        load_progress.Complete();
+        upload([&, mesh] {
+            calculator = upload_mesh(mesh->buffers);
+
+            std::unordered_set<std::string> printed;
+            for (const auto& mat : calculator.materials) {
+                if (!printed.count(mat.name)) {
+                    std::cout << "Material: " << mat.name << std::endl;
+                    printed.insert(mat.name);
+                }
+            }
+            load_progress.Complete();
+        });
+
+        // the layer uploads are queued behind the mesh upload above, so they fill the uploaded mesh
+        for (size_t layer = 0; layer < layer_paths.size(); ++layer) {
+            jobs.Submit([&, layer, layers = layer_paths.size(), path = layer_paths[layer]] {
+                int w, h, ch;
+                std::shared_ptr<unsigned char> pixels = decode_image(path, w, h, ch, 4); // RGBA
+                load_progress.Complete();
+                upload([&, layer, layers, path, w, h, pixels] {
+                    if (pixels) upload_texture_layer(calculator, layers, layer, pixels.get(), w, h, path);
+                    load_progress.Complete();
+                });
+            });
+        }
+    });
+
+    // the benchmark must not need a display server (CI runners): the null
+    // platform renders through OSMesa or a surfaceless EGL context instead
+    const bool has_display = std::getenv("DISPLAY") || std::getenv("WAYLAND_DISPLAY");
+#ifndef GLFW_PLATFORM_NULL
+    if (bench && !has_display) {
+        std::cerr << "--bench without a display needs GLFW 3.4 (null platform)" << std::endl;
+        return -1;
+    }
+#endif
+    HeadlessContext headless; // EGL context of the benchmark when GLFW has no offscreen one
 
     // try to initialize glfw
-    if (!glfwInit()) {
-        std::cerr << "GLFW init failed!" << std::endl;
-        return -1; // fail early if glfw doesn't start
+    {
+        TRACE_ZONE("glfwInit");
+#ifdef GLFW_PLATFORM_NULL
+        // no display needed: the null platform with an OSMesa context renders offscreen
+        if (bench) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+        if (!glfwInit()) {
+            std::cerr << "GLFW init failed!" << std::endl;
+            return -1; // fail early if glfw doesn't start
+        }
     }
 
-    // set window version to opengl 3.3 (compatibility profile)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // major version 3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); // minor version 3
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE); // for legacy compatibility
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    auto set_window_hints = [&bench]() {
+        // set window version to opengl 3.3 (compatibility profile)
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // major version 3
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); // minor version 3
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE); // for legacy compatibility
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        if (bench) {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // offscreen, frames are only read back
+#ifdef GLFW_PLATFORM_NULL
+            if (glfwGetPlatform() == GLFW_PLATFORM_NULL) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+        }
+    };
+    set_window_hints();
+
     // create a window sized 800x600 with title "Calculator"
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Calculator", nullptr, nullptr);
+    GLFWwindow* window;
+    {
+        TRACE_ZONE("glfwCreateWindow");
+        window = glfwCreateWindow(800, 600, "Calculator", nullptr, nullptr);
+    }
+#ifdef GLFW_PLATFORM_NULL
+    if (!window && bench && glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+        // no OSMesa available: a surfaceless EGL pbuffer context, the context-less
+        // null window only delivers events and the close flag
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow(800, 600, "Calculator", nullptr, nullptr);
+        std::string egl_error;
+        if (window && !headless.Create(800, 600, &egl_error)) {
+            std::cerr << "bench: no headless EGL context (" << egl_error << ")" << std::endl;
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+    }
+    if (!window && bench && glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+        if (!has_display) {
+            std::cerr << "--bench needs OSMesa, EGL or a display to render" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        // last resort: a hidden window on the display (GLX/EGL)
+        glfwTerminate();
+        glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+        if (glfwInit()) {
+            set_window_hints();
+            window = glfwCreateWindow(800, 600, "Calculator", nullptr, nullptr);
+        }
+    }
+#endif
     if (!window) {
         std::cerr << "Failed to open window!" << std::endl;
         glfwTerminate(); // safely shut down glfw
@@ -1031,13 +1992,18 @@ int main() {
     }
 
     // activate the window's OpenGL context
-    glfwMakeContextCurrent(window);
+    if (!headless.Active()) {
+        glfwMakeContextCurrent(window);
+        if (bench) glfwSwapInterval(0); // measure rendering, not vsync
+    }
 
     // load OpenGL functions using glad
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    GLADloadproc gl_loader = headless.Active() ? HeadlessContext::GetProcAddress : (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(gl_loader)) {
         std::cerr << "Failed to initialize GLAD!" << std::endl;
         return -1; // exit if GLAD fails
     }
+    events_ready = true;
 
     GLuint screen_FBO, screen_Texture; // framebuffer + texture for screen
 
@@ -1063,9 +2029,11 @@ int main() {
     glBindFramebuffer(GL_FRAMEBUFFER, 0); // unbind
 
 
-    // set callbacks for input
-    glfwSetKeyCallback(window, key_callback);         // for special key presses (enter, esc, etc.)
-    glfwSetCharCallback(window, character_callback);  // for character input (numbers, operators, etc.)
+    // set callbacks for input, a replay delivers recorded events to them instead
+    if (!replaying) {
+        glfwSetKeyCallback(window, key_callback);         // for special key presses (enter, esc, etc.)
+        glfwSetCharCallback(window, character_callback);  // for character input (numbers, operators, etc.)
+    }
 
     // get the size of the framebuffer (needed for viewport later)
     int width, height;
@@ -1074,7 +2042,16 @@ int main() {
 
     // load texture of font
     TextRenderer textRenderer(width, height);
-    textRenderer.Load(pather("fonts/LiberationSans-Bold.ttf"), 36);
+    {
+        TRACE_ZONE("TextRenderer::Load");
+        textRenderer.Load(pather("fonts/LiberationSans-Bold.ttf"), 36);
+    }
+
+    // frame timing overlay (timer queries + histogram buffers)
+    PerfHud perfHud;
+    RenderQueue render_queue;  // model and sky draws, sorted by state
+    GLStateCache gl_state;     // binds issued by the render queue
+    int perf_capture_count = 0;
 
     //std::string full_expression = "12 + 3 *";     // top small line
     //std::string current_value    = "36";          // bottom large line
@@ -1084,26 +2061,32 @@ int main() {
     glEnable(GL_DEPTH_TEST);
 
     // create shader program for the main scene
-    GLuint shader = createShaderProgram(pather("shaders/vertex.glsl").c_str(), pather("shaders/fragment.glsl").c_str());
+    ShaderProgram shader(pather("shaders/vertex.glsl").c_str(), pather("shaders/fragment.glsl").c_str());
 
     // create shader program for the skybox
-    GLuint skybox_shader = createShaderProgram(pather("shaders/skybox.vert").c_str(), pather("shaders/skybox.frag").c_str());
-
-    GLuint solidShader = createShaderProgram(pather("shaders/solid.vert").c_str(), pather("shaders/solid.frag").c_str());
-
-    // create vao and vbo for any debug or fallback geometry
-    GLuint vao, vbo;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao); // bind vao
-
-    // setup position attribute (x, y, z)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // setup normal attribute (nx, ny, nz)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    ShaderProgram skybox_shader(pather("shaders/skybox.vert").c_str(), pather("shaders/skybox.frag").c_str());
+
+    ShaderProgram solidShader(pather("shaders/solid.vert").c_str(), pather("shaders/solid.frag").c_str());
+
+    // camera and lighting are uploaded once per frame and shared by both 3d programs
+    UniformBuffer frame_uniforms(FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+    shader.BindBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    skybox_shader.BindBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+
+    // uniform locations used per draw, resolved once
+    const GLint model_loc = shader.Uniform("model");
+    const GLint solid_projection_loc = solidShader.Uniform("projection");
+    const GLint solid_position_loc = solidShader.Uniform("position");
+    const GLint solid_size_loc = solidShader.Uniform("size");
+    const GLint solid_color_loc = solidShader.Uniform("color");
+
+    // uniforms that never change
+    shader.Use();
+    glUniform1i(shader.Uniform("textures"), 0);                         // material texture array, unit 0
+    glUniform1i(shader.Uniform("screenTex"), 1);                        // rendered display, unit 1
+    glUniform3f(shader.Uniform("objectColor"), 0.3f, 0.7f, 1.0f);       // base color of object (light blue)
+    skybox_shader.Use();
+    glUniform1i(skybox_shader.Uniform("skybox"), 0);
 
     // setup skybox geometry
     GLuint skybox_VAO, skybox_VBO;
@@ -1117,28 +2100,6 @@ int main() {
 
 
 
-    // load paths to all 6 skybox faces
-    std::vector<std::string> faces = {
-        pather("textures/skybox/px.jpg"), // right
-        pather("textures/skybox/nx.jpg"), // left
-        pather("textures/skybox/py.jpg"), // top
-        pather("textures/skybox/ny.jpg"), // bottom
-        pather("textures/skybox/pz.jpg"), // front
-        pather("textures/skybox/nz.jpg")  // back
-    };
-
-    // launch background thread to load cubemap images
-    std::thread loaderThread([faces]() {
-            for (int i = 0; i < 6; ++i) {
-            images[i] = stbi_load(faces[i].c_str(), &widths[i], &heights[i], &channels[i], 0);
-            if (!images[i]) {
-            std::cerr << "Failed to load: " << faces[i] << std::endl;
-            }
-            cubemap_loaded_faces++; // increment on each successful load
-            }
-            cubemap_ready = true;
-            });
-
     GLuint quadVAO, quadVBO, quadEBO;
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
@@ -1157,43 +2118,25 @@ int main() {
 
     glBindVertexArray(0);
 
-    // camera rotation variables
-    float yaw = 0.0f;               // current horizontal angle
-    float pitch = 0.0f;             // current vertical angle
-    float target_yaw = 0.0f;        // desired horizontal angle
-    float target_pitch = 0.0f;      // desired vertical angle
-
-    double last_x = 0.0, last_y = 0.0; // last mouse position
-    bool dragging = false;            // whether the mouse is dragging
-
     // configure glfw input mode
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL); // show mouse
-    glfwSetScrollCallback(window, scroll_callback);             // zoom with scroll
-
-    // create texture handle for calculator texture (used in shader)
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-
-    // set texture filtering (smooth)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (!replaying) {
+        glfwSetScrollCallback(window, scroll_callback);             // zoom with scroll
+        glfwSetMouseButtonCallback(window, mouse_button_callback);  // button state for drag and clicks
+        glfwSetCursorPosCallback(window, cursor_pos_callback);      // cursor position for drag and picking
+        glfwGetCursorPos(window, &mouse.x, &mouse.y);               // the simulation thread is not running yet
+    }
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
-    // load png image from disk
-    int w, h, ch;
-    unsigned char* data = stbi_load(pather("objects/Baker.png").c_str(), &w, &h, &ch, 0);
-    if (data) {
-        // send image to gpu
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, (ch == 4 ? GL_RGBA : GL_RGB), GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmaps
+    if (!record_path.empty() && input_recorder.StartRecording(record_path)) {
+        input_record_start = glfwGetTime();
+        queue_input(InputEventType::CursorPos, 0, 0, 0, mouse.x, mouse.y); // replay starts from the same cursor
     }
-    stbi_image_free(data); // clean up image from RAM
 
-    // load calculator 3d model (.obj) and its materials
-    Mesh calculator = load_obj_model(pather("objects/calc.obj"), pather("objects/"));
+    size_t calculator_lod = 0;  // level of detail drawn last frame
 
     // define clickable buttons in 3d space (position, size, label)
-    std::vector<Button> buttons = {
+    const std::vector<Button> buttons = {
         { glm::vec3(-0.068487f, 0.020152f, 0.009860f), 0.01f, "C" },
         { glm::vec3(-0.035860f, 0.020152f, 0.009860f), 0.01f, "CE" },
         { glm::vec3(0.062499f, -0.015371f, 0.009860f), 0.01f, "/" },
@@ -1232,20 +2175,194 @@ int main() {
      *  runs until user closes the window
      */
 
-    std::unordered_set<std::string> printed;
-    for (const auto& mat : calculator.materials) {
-        if (!printed.count(mat.name)) {
-            std::cout << "Material: " << mat.name << std::endl;
-            printed.insert(mat.name);
+    current_value = "0";
+    full_expression = "";
+
+    // display strings and text buffers are reused every frame, reserved up front
+    // so steady-state frames (idle or typing) do not touch the heap
+    full_expression.reserve(256);
+    current_value.reserve(64);
+    current_input.reserve(64);
+    TextLayout expr_layout, value_layout; // relaid only when the text changes
+    char loading_text[16];
+    bool loading = true; // the loading screen shows until every asset is uploaded
+
+    // overlay text is retained on the GPU and rebuilt only when it changes
+    int loading_text_id = textRenderer.CreateStaticText();
+    int help_text_id = textRenderer.CreateStaticText();
+    int open_help_text_id = textRenderer.CreateStaticText();  // '?'
+    int close_help_text_id = textRenderer.CreateStaticText(); // 'X'
+    int loading_text_percent = -1; // progress shown by loading_text_id
+    int help_text_height = -1;    // window height the help texts were built for
+
+    // CALC_ALLOC_CHECK=1 reports frames and simulation ticks that allocate after warm-up
+    const bool alloc_check = std::getenv("CALC_ALLOC_CHECK") != nullptr;
+    const long alloc_warmup_frames = 120;
+    const long alloc_warmup_ticks = 120;
+    std::atomic<uint64_t> sim_alloc_count = 0; // simulation allocations not yet shown by the perf HUD
+    std::atomic<uint64_t> sim_alloc_bytes = 0;
+    long frame_number = 0;
+
+    // frames are only drawn while something changes
+    const double idle_timeout = 0.5;    // seconds between wake-ups while idle
+
+    bool bench_failed = false;
+    unsigned long screen_version = ~0ul; // display_version the screen texture shows
+
+    // an asset that fails to load is fatal: report it and close the window,
+    // so the threads still stop and main() returns normally
+    bool load_failed = false;
+    auto run_uploads = [&]() -> size_t {
+        try {
+            return uploads.Run(UPLOAD_BUDGET_MS);
+        } catch (const std::exception& e) {
+            std::cerr << "Loading failed: " << e.what() << std::endl;
+            load_failed = true;
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            return 1;
+        }
+    };
+
+    if (bench || replaying) {
+        // every benchmark frame renders the full scene, so all assets are uploaded first
+        while (!load_progress.Finished() && !load_failed) {
+            if (run_uploads() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
+        std::cout << (bench ? "bench" : "replay") << ": rendering with " << glGetString(GL_RENDERER) << std::endl;
     }
 
+    double replay_start = glfwGetTime();
+    if (replaying && !replay_capture.empty()) perfHud.ToggleCapture(replay_capture);
+
+    // the benchmark and fast replays render exactly one frame per simulation tick
+    const bool lockstep = bench || (replaying && replay_fast);
+    std::atomic<bool> sim_quit = false;     // set by the render loop on exit
+    std::atomic<bool> sim_finished = false; // set by the simulation when a replay ran out
+
+    // simulation thread: input, camera and calculator state at a fixed tick rate,
+    // published to the render loop through sim_snapshots
+    std::thread simThread([&]() {
+        TRACE_THREAD_NAME("simulation");
+        using SimClock = std::chrono::steady_clock;
+        const float dt = static_cast<float>(1.0 / SIM_TICK_RATE);
+        const auto tick_period = std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double>(1.0 / SIM_TICK_RATE));
+        auto next_tick = SimClock::now();
+        const auto replay_clock = next_tick; // wall time of recorded time 0
+
+        SimState state;
+        InputEvent replay_tick, event;
+        bool replay_pending = replaying && input_recorder.NextTick(replay_tick);
+
+        while (!sim_quit) {
+            bool animating;
+            {
+                TRACE_ZONE("simulation tick");
+                AllocScope tick_allocs; // input and evaluation run here, not in the frame's scope
+                if (replaying) {
+                    if (replay_pending && replay_tick.code <= state.tick) {
+                        while (const InputEvent* recorded = input_recorder.NextEvent()) apply_input(*recorded, state);
+                        replay_pending = input_recorder.NextTick(replay_tick);
+                    }
+                } else {
+                    bool first = true;
+                    while (input_queue.Pop(event)) {
+                        if (first) {
+                            // recordings only hold ticks that received input
+                            InputEvent marker;
+                            marker.time = event.time;
+                            marker.type = InputEventType::Tick;
+                            marker.code = static_cast<int32_t>(state.tick);
+                            marker.x = dt;
+                            input_recorder.Add(marker);
+                            first = false;
+                        }
+                        input_recorder.Add(event); // no-op unless recording
+                        apply_input(event, state);
+                    }
+                }
+
+                if (bench) {
+                    // scripted camera and input
+                    Benchmark::Camera(state.tick, state.yaw, state.pitch, state.radius);
+                    state.target_yaw = state.yaw;
+                    state.target_pitch = state.pitch;
+                    state.target_radius = state.radius;
+                    if (const char* label = Benchmark::Input(state.tick)) process_input(label);
+                }
+
+                animating = sim_update(state, buttons, dt, lockstep);
+                ++state.tick;
+
+                AllocStats allocs = tick_allocs.delta();
+                sim_alloc_count.fetch_add(allocs.count, std::memory_order_relaxed);
+                sim_alloc_bytes.fetch_add(allocs.bytes, std::memory_order_relaxed);
+                if (alloc_check && state.tick > alloc_warmup_ticks && allocs.count > 0) {
+                    std::cerr << "simulation tick " << state.tick << " made " << allocs.count
+                              << " heap allocations (" << allocs.bytes << " bytes)" << std::endl;
+                }
+            }
+
+            if (replaying && !replay_pending && !animating) {
+                sim_finished = true;
+                glfwPostEmptyEvent();
+                break;
+            }
+
+            if (lockstep) {
+                // wait for the render loop to take the snapshot
+                while (sim_snapshots.Fresh() && !sim_quit) std::this_thread::yield();
+                continue;
+            }
+
+            if (!animating) {
+                // settled: sleep until the next input (a recorded tick keeps its recorded time)
+                TRACE_ZONE("simulation idle");
+                std::unique_lock<std::mutex> lock(sim_wake_mutex);
+                if (replaying) {
+                    auto recorded = std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double>(replay_tick.time));
+                    sim_wake.wait_until(lock, replay_clock + recorded, [&]() { return sim_quit.load(); });
+                } else {
+                    sim_wake.wait(lock, [&]() { return !input_queue.Empty() || sim_quit; });
+                }
+                next_tick = SimClock::now();
+                continue;
+            }
+
+            // fixed rate; after a long stall start over instead of catching up
+            next_tick += tick_period;
+            auto now = SimClock::now();
+            if (now - next_tick > 10 * tick_period) next_tick = now;
+            std::this_thread::sleep_until(next_tick);
+        }
+    });
+
+    // the first frame already shows a simulated camera
+    while (!sim_snapshots.Fresh() && !sim_finished) std::this_thread::yield();
+
+    // startup time until the first frame the user can interact with, reported once after its swap
+    const double gl_setup_ms = startup_ms();
+    double assets_ms = 0.0;
+    bool first_frame_pending = true;
+    auto report_first_frame = [&] {
+        if (!first_frame_pending) return;
+        first_frame_pending = false;
+        TRACE_INSTANT("first interactive frame", "");
+        std::cout << "startup: first interactive frame after " << startup_ms() << " ms (window, GL and shaders "
+                  << gl_setup_ms << " ms, assets ready at " << assets_ms << " ms on " << jobs.ThreadCount()
+                  << " loader threads)" << std::endl;
+    };
 
-    current_value = "0";
-    full_expression = "";
     while (!glfwWindowShouldClose(window)) {
+        TRACE_ZONE("frame");
+        AllocScope frame_allocs;
+        redraw_requested = false; // events from here on ask for the next frame
+        if (bench) bench->BeginFrame();
+
+        run_uploads(); // GL work of loaded assets, spread over frames
+        if (load_failed) break;
 
-        if (show_loading && !cubemap_ready) {
+        if (loading && !load_progress.Finished()) {
+            TRACE_ZONE("loading screen");
             glClearColor(0.0f, 0.0f, 0.1f, 1.0f);  
             glClear(GL_COLOR_BUFFER_BIT);
 
@@ -1257,404 +2374,240 @@ int main() {
             glm::mat4 uprightProj = glm::ortho(0.0f, static_cast<float>(width),
                     0.0f, static_cast<float>(height));
 
-            glUseProgram(textRenderer.GetShaderID());
-            glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                    1, GL_FALSE, glm::value_ptr(uprightProj));
+            textRenderer.SetProjection(uprightProj);
 
             float scale = 1.5f;
             float centerX = width / 2.0f - 120.0f;  // Adjust this value to move the text further left
             float centerY = height / 2.0f;
 
-            // Move "Loading" a bit higher, adjust "..." and "1/6" further below "Loading"
-            textRenderer.RenderText("Loading", centerX, centerY , scale, glm::vec3(1.0f));  // Moved up
-            std::string dots(std::min(6, cubemap_loaded_faces.load()), '.');
-            textRenderer.RenderText(dots, centerX + 20.0f, centerY - 60, 3.2f, glm::vec3(1.0f));  // Adjusted positioning for dots
-            std::string countStr = std::to_string(cubemap_loaded_faces.load()) + "/6";
-            textRenderer.RenderText(countStr, centerX + 100.0f, centerY - 120, 1.2f, glm::vec3(1.0f));  // Adjusted position for count
+            // progress of every asset together, loaded and uploaded
+            int percent = static_cast<int>(load_progress.Fraction() * 100.0f);
+            if (percent != loading_text_percent) {
+                loading_text_percent = percent;
+                textRenderer.BeginStaticText(loading_text_id);
+                // Move "Loading" a bit higher, adjust "..." and "50%" further below "Loading"
+                textRenderer.AddText("Loading", centerX, centerY , scale, glm::vec3(1.0f));  // Moved up
+                textRenderer.AddText(std::string_view("......", percent * 6 / 100), centerX + 20.0f, centerY - 60, 3.2f, glm::vec3(1.0f));  // Adjusted positioning for dots
+                std::snprintf(loading_text, sizeof(loading_text), "%d%%", percent);
+                textRenderer.AddText(loading_text, centerX + 100.0f, centerY - 120, 1.2f, glm::vec3(1.0f));  // Adjusted position for count
+                textRenderer.EndStaticText();
+            }
+            textRenderer.DrawStaticText(loading_text_id);
 
             glDisable(GL_BLEND);
             glEnable(GL_DEPTH_TEST);
 
             glfwSwapBuffers(window);
-            glfwPollEvents();
+            if (uploads.Pending()) {
+                glfwPollEvents();           // uploads left over from this frame's budget
+            } else {
+                glfwWaitEventsTimeout(0.1); // loader jobs post an event per queued upload
+            }
             continue;
         }
+        if (loading) {
+            loading = false;
+            assets_ms = startup_ms();
+
+            // Restore normal HUD Y projection (origin bottom-left)
+            glm::mat4 normalProj = glm::ortho(0.0f, static_cast<float>(width),
+                    static_cast<float>(height), 0.0f);
+            textRenderer.SetProjection(normalProj);
+        }
 
 
         // =================
         //       input
         // =================
 
-        // check if middle mouse button is held
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS) {
-
-            // if this is the first frame of dragging, store cursor position
-            if (!dragging) {
-                glfwGetCursorPos(window, &last_x, &last_y);
-                dragging = true;
-            } else {
-                // get current cursor position
-                double xpos, ypos;
-                glfwGetCursorPos(window, &xpos, &ypos);
-
-                // calculate cursor movement delta
-                double dx = xpos - last_x;
-                double dy = ypos - last_y;
-
-                // rotate view based on cursor movement
-                target_yaw   -= dx * 0.3f;
-                target_pitch += dy * 0.3f;
-
-                // clamp pitch and yaw
-                if (target_yaw > 89.0f) target_yaw = 89.0f;
-                if (target_pitch < -89.0f) target_pitch = -89.0f;
-
-                last_x = xpos;
-                last_y = ypos;
-            }
-
-        } else {
-            // if not dragging, smooth out motion
-            dragging = false;
-            target_yaw   *= 0.75f;
-            target_pitch *= 0.75f;
+        // input, camera and calculator state are updated by the simulation
+        // thread, the frame shows its latest snapshot
+        perfHud.BeginFrame();
+        if (perf_capture_toggled.exchange(false)) {
+            if (!perfHud.IsCapturing()) ++perf_capture_count;
+            perfHud.ToggleCapture("perf_capture_" + std::to_string(perf_capture_count) + ".csv");
         }
 
-        // smooth interpolation of camera rotation
-        yaw   += (target_yaw - yaw) * 0.1f;
-        pitch += (target_pitch - pitch) * 0.1f;
+        TRACE_BEGIN(trace_input, "input");
+        perfHud.Begin(PerfHud::Input);
+        if (lockstep) {
+            while (!sim_snapshots.Fresh() && !sim_finished) std::this_thread::yield();
+        }
+        sim_snapshots.Update();
+        const SimSnapshot& sim = sim_snapshots.Front();
+        perfHud.End(PerfHud::Input);
+        TRACE_END(trace_input);
 
         // =================
         //    camera setup
         // =================
 
-        // create camera direction vector based on yaw and pitch
-        glm::vec3 direction;
-        direction.x = cos(glm::radians(pitch)) * sin(glm::radians(yaw));
-        direction.y = sin(glm::radians(pitch));
-        direction.z = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
-
-        // set camera position by offsetting from origin
-        glm::vec3 camera_pos = direction * radius;
-
-        // create view and projection matrices
-        glm::mat4 view = glm::lookAt(camera_pos, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 75.0f);
+        const glm::mat4& view = sim.view;
+        const glm::mat4& projection = sim.projection;
+        const glm::vec3& camera_pos = sim.camera_pos;
         glm::mat4 model = glm::mat4(1.0f); // base model transform
         model = glm::scale(model, glm::vec3(10.0f)); // scale calculator model
 
         // update viewport to current window size (handle resizes or wm oddities)
         glfwGetFramebufferSize(window, &width, &height);
         glViewport(0, 0, width, height);
+        framebuffer_width = width; // for picking on the simulation thread
+        framebuffer_height = height;
 
         // =======================
         //     rendering the calc
         // =======================
 
-        // smooth zooming (camera distance) using interpolation
-        radius += (target_radius - radius) * 0.1f;
+        // the display texture keeps its contents between frames, redraw it
+        // only when the calculator state changed since the last pass
+        TRACE_BEGIN(trace_screen, "screen FBO pass");
+        perfHud.Begin(PerfHud::ScreenPass); // skipped passes are timed too, as ~0 ms
+        if (screen_version != sim.display_version) {
+            screen_version = sim.display_version;
 
-        // bind offscreen framebuffer
-        glBindFramebuffer(GL_FRAMEBUFFER, screen_FBO);
+            // bind offscreen framebuffer
+            glBindFramebuffer(GL_FRAMEBUFFER, screen_FBO);
 
-        // set viewport to texture resolution
-        glViewport(0, 0, 512, 256);
+            // set viewport to texture resolution
+            glViewport(0, 0, 512, 256);
 
-        // clear with transparent black (or solid black)
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+            // clear with transparent black (or solid black)
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
 
-        // disable depth for 2d drawing
-        glDisable(GL_DEPTH_TEST);
+            // disable depth for 2d drawing
+            glDisable(GL_DEPTH_TEST);
 
-        // enable blending for alpha text
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            // enable blending for alpha text
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        //float screen_WIDTH = 512.0f;
-        float screen_HEIGHT = 512.0f;
+            //float screen_WIDTH = 512.0f;
+            float screen_HEIGHT = 512.0f;
 
-        float right_anchor_x = 700.0f;      // far right edge of text block
-        float left_anchor_x = 100.0f;       // far left edge of allowed text
+            float right_anchor_x = 700.0f;      // far right edge of text block
+            float left_anchor_x = 100.0f;       // far left edge of allowed text
 
-        float expr_SCALE = 1.5f;
-        float expr_line_spacing = 38.0f;
-        float max_expr_width = right_anchor_x - left_anchor_x;
+            float expr_SCALE = 1.5f;
+            float expr_line_spacing = 38.0f;
+            float max_expr_width = right_anchor_x - left_anchor_x;
 
-        std::string line1 = "", line2 = "", line3 = "";
+            expr_layout.Wrap(textRenderer, sim.full_expression, expr_SCALE, max_expr_width, 3);
 
-        for (char c : full_expression) {
-            if (textRenderer.CalculateTextWidth(line1 + c, expr_SCALE) <= max_expr_width) {
-                line1 += c;
+            float exprY = screen_HEIGHT - 38.0f;
+            for (size_t i = 0; i < expr_layout.LineCount(); ++i) {
+                const LayoutLine& line = expr_layout.Line(i);
+                textRenderer.AddText(line.text, left_anchor_x + line.x, exprY - i * expr_line_spacing, expr_SCALE, glm::vec3(0.7f));
             }
-            else if (textRenderer.CalculateTextWidth(line2 + c, expr_SCALE) <= max_expr_width) {
-                line2 += c;
-            }
-            else if (textRenderer.CalculateTextWidth(line3 + c, expr_SCALE) <= max_expr_width) {
-                line3 += c;
-            }
-            else {
-                if (line3.length() >= 3) {
-                    line3.erase(line3.size() - 3);
-                    line3 += "...";
-                } else {
-                    line3 = "...";
-                }
-                break;
-            }
-        }
 
-        float exprY = screen_HEIGHT - 38.0f;
+            // ===== Draw Result or Input =====
 
-        if (!line1.empty()) {
-            float x = right_anchor_x - textRenderer.CalculateTextWidth(line1, expr_SCALE);
-            textRenderer.RenderText(line1, x, exprY, expr_SCALE, glm::vec3(0.7f));
-        }
-        if (!line2.empty()) {
-            float x = right_anchor_x - textRenderer.CalculateTextWidth(line2, expr_SCALE);
-            textRenderer.RenderText(line2, x, exprY - expr_line_spacing, expr_SCALE, glm::vec3(0.7f));
-        }
-        if (!line3.empty()) {
-            float x = right_anchor_x - textRenderer.CalculateTextWidth(line3, expr_SCALE);
-            textRenderer.RenderText(line3, x, exprY - 2 * expr_line_spacing, expr_SCALE, glm::vec3(0.7f));
-        }
-
-        // ===== Draw Result or Input =====
-
-        std::string display_value = (!current_input.empty() && !just_evaluated)
-            ? current_input
-            : current_value;
+            // the simulation already picked input or result
+            std::string_view display_value = sim.display_value;
 
-        float value_scale = 2.8f;
-        float min_scale = 1.6f;
-        float max_value_width = right_anchor_x - left_anchor_x;
+            float value_scale = 2.8f;
+            float min_scale = 1.6f;
+            float max_value_width = right_anchor_x - left_anchor_x;
 
-        float value_width = textRenderer.CalculateTextWidth(display_value, value_scale);
+            // scale down to fit, then truncate from the left with an ellipsis
+            value_layout.FitLine(textRenderer, display_value, value_scale, min_scale, max_value_width);
 
-        // NEW TRUNCATION AFTER SCALING
-        if (value_width > max_value_width) {
-            // scale down if needed
-            value_scale *= max_value_width / value_width;
-            if (value_scale < min_scale) value_scale = min_scale;
-            value_width = textRenderer.CalculateTextWidth(display_value, value_scale);
-
-            // if still too wide, truncate characters from the left
-            if (value_width > max_value_width) {
-                bool is_negative = !display_value.empty() && display_value[0] == '-';
-                if (is_negative) display_value.erase(0, 1); // strip minus temporarily
-
-                while (textRenderer.CalculateTextWidth(display_value, value_scale) > max_value_width
-                        && display_value.length() > 1) {
-                    display_value.erase(0, 1);
-                }
-
-                display_value = "…" + display_value;
-                if (is_negative) display_value = "-" + display_value;
-
-                value_width = textRenderer.CalculateTextWidth(display_value, value_scale);
+            if (value_layout.LineCount() > 0) {
+                const LayoutLine& line = value_layout.Line(0);
+                float value_y = 60.0f;
+                textRenderer.AddText(line.text, left_anchor_x + line.x, value_y, value_layout.Scale(), glm::vec3(1.0f));
             }
-        }
-
-        float value_x = right_anchor_x - value_width;
-        float value_y = 60.0f;
 
-        textRenderer.RenderText(display_value, value_x, value_y, value_scale, glm::vec3(1.0f));
+            textRenderer.Flush(); // all display text in one draw
 
-        // cleanup state
-        glDisable(GL_BLEND);
-        glEnable(GL_DEPTH_TEST);
+            // cleanup state
+            glDisable(GL_BLEND);
+            glEnable(GL_DEPTH_TEST);
 
-        // return to normal framebuffer
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // return to normal framebuffer
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        perfHud.End(PerfHud::ScreenPass);
+        TRACE_END(trace_screen);
         glfwGetFramebufferSize(window, &width, &height);
         glViewport(0, 0, width, height);
 
-        // activate texture unit 0
-        glActiveTexture(GL_TEXTURE0);
-
-        // bind calculator texture
-        glBindTexture(GL_TEXTURE_2D, tex);
+        // queue the 3d draws, they are issued sorted by program, texture and vao
+        render_queue.Clear();
+
+        DrawPacket packet;
+        packet.pass = RenderPass::Model;
+        packet.program = shader.ID();
+        packet.modelLoc = model_loc;
+        packet.model = model;
+
+        // the whole calculator is one draw: materials are texture array layers, the display on unit 1
+        packet.texture = calculator.texture_array;
+        packet.textureTarget = GL_TEXTURE_2D_ARRAY;
+        packet.screenTexture = screen_Texture;
+        packet.vao = calculator.vao;
+
+        // level of detail from the projected size: pixels per model unit at the calculator's nearest point
+        const float model_scale = glm::length(glm::vec3(model[0]));
+        const float lod_distance = std::max(glm::length(camera_pos) - calculator.radius * model_scale, 0.1f);
+        calculator_lod = select_lod(calculator.lods, calculator_lod,
+                                    projection[1][1] * 0.5f * height / lod_distance * model_scale);
+        packet.first = calculator.lods[calculator_lod].firstIndex;
+        packet.count = static_cast<GLsizei>(calculator.lods[calculator_lod].indexCount);
+        packet.indexType = calculator.index_type;
+        render_queue.Submit(packet);
+
+        // no sky until all six faces are in, the clear color shows meanwhile
+        if (cubemap_loaded) {
+            packet = DrawPacket{};
+            packet.pass = RenderPass::Sky;
+            packet.indexed = false;
+            packet.count = 36;
+            packet.program = skybox_shader.ID(); // camera comes from the frame uniform block
+            packet.textureTarget = GL_TEXTURE_CUBE_MAP;
+            packet.texture = cubemap_texture;
+            packet.vao = skybox_VAO;
+            render_queue.Submit(packet);
+        }
 
-        // send texture to shader as "tex" uniform
-        glUniform1i(glGetUniformLocation(shader, "tex"), 0);
+        TRACE_BEGIN(trace_model, "model pass");
+        perfHud.Begin(PerfHud::ModelPass);
 
         // set background color (dark grey) and clear buffers
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // use main shader program
-        glUseProgram(shader);
-
-        // send camera position as light position and view position
-        glUniform3fv(glGetUniformLocation(shader, "lightPos"), 1, glm::value_ptr(camera_pos));
-        glUniform3fv(glGetUniformLocation(shader, "viewPos"), 1, glm::value_ptr(camera_pos));
-
-        // override light position to a fixed point in front of the scene
-        glm::vec3 light_position = glm::vec3(0.0f, 0.0f, 5.0f);
-        glUniform3fv(glGetUniformLocation(shader, "lightPos"), 1, glm::value_ptr(light_position));
-
-        // send model/view/projection matrices to the shader
-        glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-        // setup basic directional light (used in fragment shader)
-        glUniform3f(glGetUniformLocation(shader, "lightDir"), -0.5f, -1.0f, -0.3f);
-        glm::vec3 dimLight = glm::vec3(0.3f); // soft light
-        glUniform3fv(glGetUniformLocation(shader, "lightColor"), 1, glm::value_ptr(dimLight));
-
-        // set base color of object (light blue)
-        glUniform3f(glGetUniformLocation(shader, "objectColor"), 0.3f, 0.7f, 1.0f);
-        // loop through all submeshes of the calculator model
-        for (const auto& sub : calculator.submeshes) {
-            GLuint texID = 0;          // default texture id
-            std::string matName;       // name of the material
-
-            // if the submesh has a valid material, get its info
-            if (sub.material_ID >= 0 && static_cast<size_t>(sub.material_ID) < calculator.materials.size()) {
-                texID = calculator.materials[sub.material_ID].illum; // we store texture id in illum (repurposed)
-                matName = calculator.materials[sub.material_ID].name;
-            }
-
-            // activate shader and texture
-            glUseProgram(shader);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texID);
-            glUniform1i(glGetUniformLocation(shader, "tex"), 0);
-
-            // update matrix uniforms
-            glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-            // setup light direction and color
-            glUniform3f(glGetUniformLocation(shader, "lightDir"), -0.5f, -1.0f, -0.3f);
-            glUniform3f(glGetUniformLocation(shader, "lightColor"), 0.7f, 0.7f, 0.7f);
-
-            if (matName == "Material.027") {
-                glBindTexture(GL_TEXTURE_2D, screen_Texture); // use rendered screen
-            } else {
-                glBindTexture(GL_TEXTURE_2D, texID); // normal material texture
-            }
-
-            // draw the submesh
-            glBindVertexArray(sub.vao);
-            glDrawElements(GL_TRIANGLES, sub.indices.size(), GL_UNSIGNED_INT, 0);
-        }
-
-        // handle mouse clicks with debounce (one click per press)
-        static bool was_pressed = false; // remember last press state
-
-        // check if left mouse is pressed and wasn't pressed before
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !was_pressed) {
-            was_pressed = true; // mark press to avoid spamming
-
-            double mx, my;
-            glfwGetCursorPos(window, &mx, &my); // get mouse screen coords
-
-            // convert screen to normalized device coordinates (-1 to 1)
-            float ndc_x = 2.0f * mx / width - 1.0f;
-            float ndc_y = 1.0f - 2.0f * my / height;
-            glm::vec4 ray_clip(ndc_x, ndc_y, -1.0f, 1.0f); // ray in clip space
-
-            // convert ray to eye space
-            glm::vec4 ray_eye = glm::inverse(projection) * ray_clip;
-            ray_eye = glm::vec4(ray_eye.x, ray_eye.y, -1.0f, 0.0f); // set direction
-
-            // convert ray to world space
-            glm::vec3 ray_world = glm::vec3(glm::inverse(view) * ray_eye);
-            ray_world = glm::normalize(ray_world); // make it unit vector
-
-            // check ray collision with each button
-            for (const auto& btn : buttons) {
-                // direction to button from camera
-                glm::vec3 toButton = (btn.position * 10.0f - camera_pos);
-
-                // t = projected distance along ray
-                float t = glm::dot(toButton, ray_world);
-                if (t < 0.0f) continue; // ignore buttons behind camera
-
-                // point on ray closest to button
-                glm::vec3 closest = camera_pos + ray_world * t;
-
-                // distance from that point to button center
-                float distance = glm::length(closest - btn.position * 10.0f);
-
-                // if within button radius, it's a hit
-                if (distance < btn.size * 15.0f) {
-                    process_input(btn.label); // process the button label
-                }
-            }
-
-        } else if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-            was_pressed = false; // reset press state on release
-        }
-
-        static bool uploadedCubemap = false; // one-time upload flag
-
-        // if cubemap is ready and not yet uploaded
-        if (cubemap_ready && !uploadedCubemap) {
-            glGenTextures(1, &cubemap_texture); // generate texture id
-            glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_texture); // bind cube map
-
-            for (int i = 0; i < 6; ++i) {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
-                        widths[i], heights[i], 0, GL_RGB, GL_UNSIGNED_BYTE, images[i]);
-                stbi_image_free(images[i]);
-            }
-
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-            uploadedCubemap = true;
-            cubemap_loaded = true;
-            show_loading = false;
-
-            // Restore normal HUD Y projection (origin bottom-left)
-            glm::mat4 normalProj = glm::ortho(0.0f, static_cast<float>(width),
-                    static_cast<float>(height), 0.0f);
-            glUseProgram(textRenderer.GetShaderID());
-            glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                    1, GL_FALSE, &normalProj[0][0]);
-        }
-
+        // camera and lighting for every 3d program, one upload per frame
+        FrameUniforms frame;
+        frame.view = view;
+        frame.projection = projection;
+        frame.sky_view = glm::mat4(glm::mat3(view)); // remove translation from view
+        frame.view_pos = glm::vec4(camera_pos, 1.0f);
+        frame.light_pos = glm::vec4(0.0f, 0.0f, 5.0f, 1.0f); // fixed point in front of the scene
+        frame.light_color = glm::vec4(0.7f, 0.7f, 0.7f, 1.0f);
+        frame_uniforms.Update(&frame);
+
+        gl_state.BeginFrame(); // the screen pass and overlay bind objects directly
+        render_queue.Execute(gl_state, RenderPass::Model);
+        perfHud.End(PerfHud::ModelPass);
+        TRACE_END(trace_model);
 
         // render skybox
+        TRACE_BEGIN(trace_skybox, "skybox pass");
+        perfHud.Begin(PerfHud::Skybox);
         glDepthFunc(GL_LEQUAL); // allow skybox to draw behind everything
+        render_queue.Execute(gl_state, RenderPass::Sky);
+        perfHud.End(PerfHud::Skybox);
+        TRACE_END(trace_skybox);
+        perfHud.SetRenderStats(gl_state.Stats());
 
-        if (cubemap_loaded) {
-            glUseProgram(skybox_shader); // use skybox shader
-
-            glm::mat4 viewSky = glm::mat4(glm::mat3(view)); // remove translation from view
-            glUniformMatrix4fv(glGetUniformLocation(skybox_shader, "view"), 1, GL_FALSE, glm::value_ptr(viewSky));
-            glUniformMatrix4fv(glGetUniformLocation(skybox_shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-            glBindVertexArray(skybox_VAO);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_texture);
-            glDrawArrays(GL_TRIANGLES, 0, 36); // draw cube
-        } else {
-            // draw placeholder cube while loading
-            glUseProgram(shader);
-            glm::mat4 loadingModel = glm::scale(model, glm::vec3(0.5f));
-            glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(loadingModel));
-            glBindVertexArray(vao);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
-
-
+        TRACE_BEGIN(trace_hud, "HUD/help pass");
+        perfHud.Begin(PerfHud::Overlay);
         glm::mat4 hudProjection = glm::ortho(
                 0.0f, static_cast<float>(width),
                 0.0f, static_cast<float>(height));
 
 
-        glUseProgram(textRenderer.GetShaderID());
-        glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                1, GL_FALSE, glm::value_ptr(hudProjection));
-
-
         glDepthFunc(GL_LESS); // restore default depth function
 
 
@@ -1665,9 +2618,7 @@ int main() {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glUseProgram(textRenderer.GetShaderID());
-        glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                1, GL_FALSE, glm::value_ptr(hudProjection));
+        textRenderer.SetProjection(hudProjection);
 
 
         // Common button properties (for both '?' and 'X')
@@ -1675,90 +2626,73 @@ int main() {
         float buttonY = height - 80.0f;  // Y position (from top)
         float buttonScale = 2.0f; // Scale (size)
 
-        static bool was_pressed_2d = false;
-
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
-        float flippedY = height - mouseY; // flip Y to OpenGL coordinates
-
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !was_pressed_2d) {
-            was_pressed_2d = true;
-
-            if (show_help_overlay) {
-                // Click on 'X' to close
-                if (mouseX >= buttonX - 10 && mouseX <= buttonX + 40 &&
-                        flippedY >= buttonY - 10 && flippedY <= buttonY + 40) {
-                    show_help_overlay = false;
-                    std::cout << "Help closed via X" << std::endl;
-                }
-            } else {
-                // Click on '?' to open
-                if (mouseX >= buttonX - 10 && mouseX <= buttonX + 40 &&
-                        flippedY >= buttonY - 10 && flippedY <= buttonY + 40) {
-                    show_help_overlay = true;
-                    std::cout << "Toggled Help: ON" << std::endl;
-                }
-            }
-        } else if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-            was_pressed_2d = false;
-        }
-
         // During rendering
+        // help and button text is retained, perf overlay text is queued and drawn by one Flush() at the end
 
-        if (show_help_overlay) {
-            textRenderer.RenderText("X", buttonX, buttonY, buttonScale, glm::vec3(1.0f, 0.0f, 0.0f)); // Red X
-        } else {
-            textRenderer.RenderText("?", buttonX, buttonY, buttonScale, glm::vec3(1.0f)); // White ?
-        }
+        // help text and the buttons only move when the window height changes
+        if (height != help_text_height) {
+            help_text_height = height;
 
+            float helpX = 40.0f;
+            float helpY = height - 60.0f;
+            float scale = 0.6f;
+            glm::vec3 textColor(0.9f, 0.9f, 0.9f);  // white text
 
-        if (show_help_overlay) {
-            glDisable(GL_DEPTH_TEST);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            textRenderer.BeginStaticText(help_text_id);
+            textRenderer.AddText("      -- HELP MODE --", helpX, helpY, scale, textColor);
+            textRenderer.AddText("          - Click buttons or type keys to input", helpX, helpY - 40, scale, textColor);
+            textRenderer.AddText("          - Press <del> to clear, <backspace> to clear entry", helpX, helpY - 80, scale, textColor);
+            textRenderer.AddText("          - Mouse wheel zooms view", helpX, helpY - 120, scale, textColor);
+            textRenderer.AddText("          - Middle mouse drag rotates model", helpX, helpY - 160, scale, textColor);
+            textRenderer.AddText("          - Click 'X' in top-left to close this overlay", helpX, helpY - 200, scale, textColor);
+            textRenderer.AddText("          - To use pi on keyboard - p", helpX, helpY - 240, scale, textColor);
+            textRenderer.AddText("          - To use e on keyboard - e", helpX, helpY - 280, scale, textColor);
+            textRenderer.AddText("          - Root on keyboard - r", helpX, helpY - 320, scale, textColor);
+            textRenderer.AddText("          - Modulo on keyboard - %", helpX, helpY - 360, scale, textColor);
+            textRenderer.AddText("          - Power on keyboard - ^", helpX, helpY - 400, scale, textColor);
+			textRenderer.AddText("          - Factorial on keyboard - !", helpX, helpY - 440, scale, textColor);
+            textRenderer.AddText("          - F3 performance overlay, F4 record csv capture", helpX, helpY - 480, scale, textColor);
+            textRenderer.EndStaticText();
+
+            textRenderer.BeginStaticText(close_help_text_id);
+            textRenderer.AddText("X", buttonX, buttonY, buttonScale, glm::vec3(1.0f, 0.0f, 0.0f)); // Red X
+            textRenderer.EndStaticText();
+
+            textRenderer.BeginStaticText(open_help_text_id);
+            textRenderer.AddText("?", buttonX, buttonY, buttonScale, glm::vec3(1.0f)); // White ?
+            textRenderer.EndStaticText();
+        }
 
+        if (sim.show_help_overlay) {
             glm::mat4 proj = glm::ortho(0.0f, static_cast<float>(width),
                     0.0f, static_cast<float>(height));
 
             // Render translucent white background
-            glUseProgram(solidShader);
-            glUniformMatrix4fv(glGetUniformLocation(solidShader, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-            glUniform2f(glGetUniformLocation(solidShader, "position"), 0.0f, 0.0f);
-            glUniform2f(glGetUniformLocation(solidShader, "size"), static_cast<float>(width), static_cast<float>(height));
-            glUniform3f(glGetUniformLocation(solidShader, "color"), 0.1f, 0.1f, 0.1f); // Alpha handled in frag shader
+            solidShader.Use();
+            glUniformMatrix4fv(solid_projection_loc, 1, GL_FALSE, glm::value_ptr(proj));
+            glUniform2f(solid_position_loc, 0.0f, 0.0f);
+            glUniform2f(solid_size_loc, static_cast<float>(width), static_cast<float>(height));
+            glUniform3f(solid_color_loc, 0.1f, 0.1f, 0.1f); // Alpha handled in frag shader
             glBindVertexArray(quadVAO);
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
             // Render help text
-            glUseProgram(textRenderer.GetShaderID());
-            glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                    1, GL_FALSE, glm::value_ptr(proj));
-
-            float helpX = 40.0f;
-            float helpY = height - 60.0f;
-            float scale = 0.6f;
-            glm::vec3 textColor(0.9f, 0.9f, 0.9f);  // white text
+            textRenderer.SetProjection(proj);
 
-            textRenderer.RenderText("      -- HELP MODE --", helpX, helpY, scale, textColor);
-            textRenderer.RenderText("          - Click buttons or type keys to input", helpX, helpY - 40, scale, textColor);
-            textRenderer.RenderText("          - Press <del> to clear, <backspace> to clear entry", helpX, helpY - 80, scale, textColor);
-            textRenderer.RenderText("          - Mouse wheel zooms view", helpX, helpY - 120, scale, textColor);
-            textRenderer.RenderText("          - Middle mouse drag rotates model", helpX, helpY - 160, scale, textColor);
-            textRenderer.RenderText("          - Click 'X' in top-left to close this overlay", helpX, helpY - 200, scale, textColor);
-            textRenderer.RenderText("          - To use pi on keyboard - p", helpX, helpY - 240, scale, textColor);
-            textRenderer.RenderText("          - To use e on keyboard - e", helpX, helpY - 280, scale, textColor);
-            textRenderer.RenderText("          - Root on keyboard - r", helpX, helpY - 320, scale, textColor);
-            textRenderer.RenderText("          - Modulo on keyboard - %", helpX, helpY - 360, scale, textColor);
-            textRenderer.RenderText("          - Power on keyboard - ^", helpX, helpY - 400, scale, textColor);
-			textRenderer.RenderText("          - Factorial on keyboard - !", helpX, helpY - 440, scale, textColor);
+            textRenderer.DrawStaticText(help_text_id);
 
             // Draw 'X' close button
-            textRenderer.RenderText("X", buttonX, buttonY, buttonScale, glm::vec3(1.0f, 0.0f, 0.0f));
+            textRenderer.DrawStaticText(close_help_text_id);
+        } else {
+            textRenderer.DrawStaticText(open_help_text_id);
+        }
 
-            glDisable(GL_BLEND);
-            glEnable(GL_DEPTH_TEST);
+        if (show_perf_hud) {
+            perfHud.Render(textRenderer, static_cast<float>(height), hudProjection);
         }
 
+        textRenderer.Flush();
+
 
         // Restore the normal text projection
         glm::mat4 normalProjection = glm::ortho(
@@ -1766,23 +2700,86 @@ int main() {
                 static_cast<float>(height), 0.0f
                 );
 
-        glUseProgram(textRenderer.GetShaderID());
-        glUniformMatrix4fv(glGetUniformLocation(textRenderer.GetShaderID(), "projection"),
-                1, GL_FALSE, glm::value_ptr(normalProjection));
+        textRenderer.SetProjection(normalProjection);
 
         // Restore OpenGL state
         glDisable(GL_BLEND);
         glEnable(GL_DEPTH_TEST);
+        perfHud.End(PerfHud::Overlay);
+        perfHud.EndFrame();
+        TRACE_END(trace_hud);
+
 
+        // keep drawing while the perf overlay shows live timings or a texture
+        // upload is still pending, camera motion arrives as new snapshots
+        bool animating = show_perf_hud || perfHud.IsCapturing() || !cubemap_loaded;
+
+        if (bench) {
+            // read back before the swap, the back buffer is undefined afterwards
+            if (bench->LastFrame() && !bench->SaveFrame(width, height)) bench_failed = true;
+            if (headless.Active()) headless.SwapBuffers();
+            else glfwSwapBuffers(window);
+            report_first_frame();
+            glfwPollEvents();
+            bench->EndFrame();
+            if (bench->Done()) glfwSetWindowShouldClose(window, GLFW_TRUE);
+        } else {
+            TRACE_ZONE("swap + poll");
+            glfwSwapBuffers(window); // swap front and back buffer
+            report_first_frame();
+            if (sim_finished && !sim_snapshots.Fresh()) {
+                glfwSetWindowShouldClose(window, GLFW_TRUE); // replay shown to the end
+            }
+            if (animating || redraw_requested || lockstep || sim_snapshots.Fresh()) {
+                glfwPollEvents();    // handle window + input events
+            } else {
+                // idle: sleep until the simulation publishes or the window needs a redraw
+                while (!redraw_requested && !sim_snapshots.Fresh() && !sim_finished
+                        && !glfwWindowShouldClose(window)) {
+                    glfwWaitEventsTimeout(idle_timeout);
+                }
+            }
+        }
 
+        // input callbacks only queue events, the simulation thread does the work;
+        // the HUD shows its allocations since the last frame along with the frame's own
+        AllocStats allocs = frame_allocs.delta();
+        perfHud.SetFrameAllocations(allocs.count + sim_alloc_count.exchange(0, std::memory_order_relaxed),
+                                    allocs.bytes + sim_alloc_bytes.exchange(0, std::memory_order_relaxed));
+        ++frame_number;
+        if (alloc_check && frame_number > alloc_warmup_frames && allocs.count > 0) {
+            std::cerr << "frame " << frame_number << " made " << allocs.count
+                      << " heap allocations (" << allocs.bytes << " bytes)" << std::endl;
+        }
+    }
 
-        glfwSwapBuffers(window); // swap front and back buffer
-        glfwPollEvents();        // handle window + input events
+    // stop the simulation before the context and window go away
+    sim_quit = true;
+    { std::lock_guard<std::mutex> lock(sim_wake_mutex); }
+    sim_wake.notify_one();
+    simThread.join();
+
+    if (bench && !load_failed) {
+        bench->Report(std::cout);
+        const RenderStats& stats = gl_state.Stats(); // last frame, every bench frame draws the same scene
+        std::cout << "render: " << stats.draws << " draws, " << stats.Binds() << " binds (" << stats.skippedBinds
+                  << " skipped), " << stats.uniformUploads << " uniform uploads, " << stats.triangles
+                  << " triangles per frame" << std::endl;
+    }
+    if (replaying) {
+        if (perfHud.IsCapturing()) perfHud.ToggleCapture(replay_capture);
+        double seconds = glfwGetTime() - replay_start;
+        std::cout << "replay: " << input_recorder.TickCount() << " input ticks, " << frame_number << " frames in "
+                  << seconds << " s (" << frame_number / seconds << " fps)" << std::endl;
+    }
+    if (input_recorder.GetMode() == InputRecorder::Mode::Record) {
+        std::cout << "recorded " << input_recorder.TickCount() << " input ticks to " << record_path << std::endl;
     }
 
-    loaderThread.join(); // wait for skybox thread to finish
-    glfwTerminate();     // shutdown window + context
-    return 0;            // exit successfully
+    jobs.Stop();     // loader jobs still running post events, finish them first
+    glfwTerminate(); // shutdown window + context
+    TRACE_WRITE(std::getenv("CALC_TRACE_FILE")); // chrome trace json (tracing builds only)
+    return bench_failed || load_failed ? 1 : 0; // exit successfully
 }
 
 /* end of file main.cpp */
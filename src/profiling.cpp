@@ -1,3 +1,4 @@
+#include <vector>
 #include "include/mathlibrary.h"
 
 /**
@@ -12,6 +13,11 @@ double calculate_stddev() {
     double sum = 0.0;
     double sum_squares = 0.0;
 
+    // values are collected in batches and summed by the SIMD kernel
+    std::vector<double> batch;
+    const size_t batch_size = 4096;
+    batch.reserve(batch_size);
+
     // Read numbers from standard input
     while (std::cin >> token) {
         if (token == "e" || token == "end") {
@@ -26,10 +32,14 @@ double calculate_stddev() {
             continue;
         }
 
-        sum = Calculator::add(sum, x);
-        sum_squares = Calculator::add(sum_squares, Calculator::mul(x, x));
+        batch.push_back(x);
         N++;
+        if (batch.size() == batch_size) {
+            Calculator::accumulate(batch.data(), batch.size(), sum, sum_squares);
+            batch.clear();
+        }
     }
+    Calculator::accumulate(batch.data(), batch.size(), sum, sum_squares);
 
     // At least two numbers are needed to calculate standard deviation
     if (N < 2) {
@@ -3,30 +3,44 @@
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+flat in float Layer; // texture array layer, -1 for the display, -2 for no texture
 
 out vec4 FragColor;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 lightColor;
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 skyView;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
 uniform vec3 objectColor;
-uniform sampler2D tex;
+uniform sampler2DArray textures; // material textures
+uniform sampler2D screenTex;      // rendered calculator display
 uniform bool useObjectColor; // 👈 add toggle
 
 void main() {
-    vec3 baseColor = useObjectColor ? objectColor : texture(tex, TexCoord).rgb;
+    vec3 texColor = vec3(0.0);
+    if (Layer >= 0.0) {
+        texColor = texture(textures, vec3(TexCoord, Layer)).rgb;
+    } else if (Layer > -1.5) {
+        texColor = texture(screenTex, TexCoord).rgb;
+    }
+    vec3 baseColor = useObjectColor ? objectColor : texColor;
 
     // Lighting
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
 
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
 
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-    vec3 specular = spec * lightColor * 0.5;
+    vec3 specular = spec * lightColor.rgb * 0.5;
 
     vec3 ambient = vec3(0.25, 0.25, 0.3);
 
@@ -3,13 +3,19 @@ layout(location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 skyView;    // view without translation
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
 
 void main()
 {
     TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    vec4 pos = projection * skyView * vec4(aPos, 1.0);
     gl_Position = pos.xyww; // keep depth at 1.0
 }
 
@@ -1,13 +1,19 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 FragColor;
 
 uniform sampler2D text;
-uniform vec3 textColor;
+uniform bool sdf; // atlas holds signed distance fields (edge at 0.5)
 
 void main()
 {
-    float alpha = texture(text, TexCoords).r;
-    FragColor = vec4(textColor, alpha);
+    float value = texture(text, TexCoords).r;
+    float alpha = value;
+    if (sdf) {
+        // antialias over about one screen pixel, whatever the text scale
+        float width = max(fwidth(value) * 0.75, 1e-4);
+        alpha = smoothstep(0.5 - width, 0.5 + width, value);
+    }
+    FragColor = vec4(TextColor, alpha);
 }
-
@@ -1,6 +1,8 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // (x, y, u, v)
+layout (location = 1) in vec3 color;  // per-vertex text color
 out vec2 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
 
@@ -8,5 +10,5 @@ void main()
 {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
+    TextColor = color;
 }
-
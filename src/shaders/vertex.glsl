@@ -3,20 +3,30 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord; // texture coordinates
 layout (location = 2) in vec3 aNormal;
+layout (location = 3) in float aLayer;   // texture array layer of the material
+
+// per-frame camera and lighting, shared with the skybox (see FrameUniforms in main_gui.cpp)
+layout (std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 skyView;    // view without translation
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
 
 uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+flat out float Layer;
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = aTexCoord;
+    Layer = aLayer;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
-
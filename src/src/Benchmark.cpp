@@ -0,0 +1,189 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Headless rendering benchmark and PNG frame dump.
+ */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <glad/glad.h>
+
+
+namespace {
+
+// buttons pressed in turn, one every INPUT_INTERVAL ticks, so the screen pass runs too
+const char* const inputScript[] = { "1", "2", "3", "+", "4", "5", "6", "*", "7", "8", "9", "=", "C" };
+constexpr int INPUT_INTERVAL = 20;
+
+constexpr float TWO_PI = 6.28318531f;
+
+uint32_t crcTable[256];
+
+uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+    if (crcTable[1] == 0) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crcTable[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void PutBE32(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+void WriteChunk(std::ofstream& file, const char type[4], const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> chunk;
+    chunk.reserve(data.size() + 12);
+    PutBE32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    PutBE32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4)); // crc over type + data
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+} // namespace
+
+
+Benchmark::Benchmark(int frames, std::string pngPath)
+    : frames(frames), pngPath(std::move(pngPath)) {
+    frameTimes.reserve(frames);
+}
+
+
+void Benchmark::BeginFrame() {
+    frameStart = Clock::now();
+}
+
+
+void Benchmark::EndFrame() {
+    glFinish(); // count the rendering itself, not just submitting it
+    frameTimes.push_back(std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count());
+    ++frame;
+}
+
+
+void Benchmark::Camera(long tick, float& yaw, float& pitch, float& radius) {
+    // orbit around the calculator while slowly zooming in and out, 60 ticks per second of path
+    float t = tick / 60.0f;
+    yaw    = 40.0f * std::sin(TWO_PI * t / 6.0f);
+    pitch  = 20.0f * std::sin(TWO_PI * t / 4.0f);
+    radius = 5.0f + 2.0f * std::sin(TWO_PI * t / 8.0f);
+}
+
+
+const char* Benchmark::Input(long tick) {
+    if (tick % INPUT_INTERVAL != 0) return nullptr;
+    constexpr int count = sizeof(inputScript) / sizeof(inputScript[0]);
+    return inputScript[(tick / INPUT_INTERVAL) % count];
+}
+
+
+bool Benchmark::SaveFrame(int width, int height) const {
+    if (pngPath.empty()) return true;
+
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    // GL rows start at the bottom, PNG rows at the top
+    size_t stride = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height / 2; ++y) {
+        std::swap_ranges(pixels.begin() + y * stride, pixels.begin() + (y + 1) * stride,
+                         pixels.begin() + (height - 1 - y) * stride);
+    }
+
+    if (!WritePng(pngPath, width, height, pixels.data())) {
+        std::cerr << "failed to write " << pngPath << std::endl;
+        return false;
+    }
+    std::cout << "wrote last frame to " << pngPath << std::endl;
+    return true;
+}
+
+
+void Benchmark::Report(std::ostream& out) const {
+    if (frameTimes.empty()) {
+        out << "bench: no frames rendered" << std::endl;
+        return;
+    }
+
+    std::vector<float> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](float p) {
+        size_t k = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+        return sorted[k];
+    };
+    float mean = std::accumulate(sorted.begin(), sorted.end(), 0.0f) / sorted.size();
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "bench: %zu frames, mean %.3f ms (%.1f fps), p50 %.3f, p90 %.3f, p99 %.3f, max %.3f ms",
+                  sorted.size(), mean, 1000.0f / mean,
+                  percentile(0.50f), percentile(0.90f), percentile(0.99f), sorted.back());
+    out << line << std::endl;
+}
+
+
+bool WritePng(const std::string& path, int width, int height, const unsigned char* rgba) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<unsigned char> header;
+    PutBE32(header, width);
+    PutBE32(header, height);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8-bit RGBA, no interlacing
+    WriteChunk(file, "IHDR", header);
+
+    // scanlines with filter type 0, wrapped in stored (uncompressed) deflate blocks
+    size_t stride = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * stride, rgba + (y + 1) * stride);
+    }
+
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    size_t offset = 0;
+    do {
+        size_t block = std::min<size_t>(raw.size() - offset, 65535);
+        bool final = offset + block == raw.size();
+        zlib.push_back(final ? 1 : 0);
+        zlib.push_back(block & 0xFF);
+        zlib.push_back(block >> 8);
+        zlib.push_back(~block & 0xFF);
+        zlib.push_back((~block >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block);
+        offset += block;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0; // adler-32 of the uncompressed data
+    for (unsigned char byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    PutBE32(zlib, (b << 16) | a);
+    WriteChunk(file, "IDAT", zlib);
+    WriteChunk(file, "IEND", {});
+
+    return static_cast<bool>(file);
+}
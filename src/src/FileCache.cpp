@@ -0,0 +1,33 @@
+/**
+ * @file FileCache.cpp
+ * @brief Cache directory lookup and source hashing shared by the on-disk caches.
+ */
+
+#include "FileCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+
+std::string CacheDir(const char* envVar) {
+    if (const char* dir = std::getenv(envVar)) {
+        return std::strcmp(dir, "off") == 0 ? std::string() : std::string(dir);
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) return std::string(xdg) + "/ivs_calculator";
+    if (const char* home = std::getenv("HOME"); home && *home) return std::string(home) + "/.cache/ivs_calculator";
+    return std::string();
+}
+
+
+uint64_t HashFile(const std::string& path, uint64_t hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    char buffer[16384];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        for (std::streamsize i = 0; i < in.gcount(); ++i) {
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file GlyphAtlas.cpp
+ * @brief Shelf packing of glyph bitmaps into a single atlas.
+ */
+
+#include "GlyphAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+GlyphAtlas::GlyphAtlas(int width, int height, int padding)
+    : width(width), height(height), padding(padding), pixels(static_cast<size_t>(width) * height, 0) {}
+
+
+bool GlyphAtlas::Pack(int w, int h, AtlasRect& rect) {
+    int paddedW = w + 2 * padding;
+    int paddedH = h + 2 * padding;
+
+    // best shelf = fits and wastes the least height
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(shelves.size()); ++i) {
+        const Shelf& shelf = shelves[i];
+        if (shelf.height >= paddedH && width - shelf.x >= paddedW) {
+            if (best < 0 || shelf.height < shelves[best].height) best = i;
+        }
+    }
+
+    if (best < 0) {
+        if (nextShelfY + paddedH > height || paddedW > width) return false;
+        shelves.push_back({ nextShelfY, paddedH, 0 });
+        nextShelfY += paddedH;
+        best = static_cast<int>(shelves.size()) - 1;
+    }
+
+    Shelf& shelf = shelves[best];
+    rect = { shelf.x + padding, shelf.y + padding, w, h, best };
+    shelf.x += paddedW;
+    return true;
+}
+
+
+void GlyphAtlas::Blit(const AtlasRect& rect, const unsigned char* src, int pitch) {
+    for (int row = 0; row < rect.h; ++row) {
+        std::memcpy(&pixels[static_cast<size_t>(rect.y + row) * width + rect.x], src + row * pitch, rect.w);
+    }
+}
+
+
+void GlyphAtlas::Clear() {
+    shelves.clear();
+    nextShelfY = 0;
+    std::fill(pixels.begin(), pixels.end(), 0);
+}
+
+
+void GlyphAtlas::Restore(const Shelf* savedShelves, int shelfCount, int savedNextShelfY, const unsigned char* savedPixels) {
+    shelves.assign(savedShelves, savedShelves + shelfCount);
+    nextShelfY = savedNextShelfY;
+    std::memcpy(pixels.data(), savedPixels, pixels.size());
+}
+
+
+void GlyphAtlas::ClearShelf(int shelf) {
+    Shelf& s = shelves[shelf];
+    s.x = 0;
+    std::fill(pixels.begin() + static_cast<size_t>(s.y) * width,
+              pixels.begin() + static_cast<size_t>(s.y + s.height) * width, 0);
+}
+
+
+bool GlyphAtlas::ShelfFits(int shelf, int w, int h) const {
+    return shelves[shelf].height >= h + 2 * padding && width >= w + 2 * padding;
+}
+
+
+AtlasRect GlyphAtlas::ShelfBounds(int shelf) const {
+    const Shelf& s = shelves[shelf];
+    return { 0, s.y, width, s.height, shelf };
+}
@@ -0,0 +1,171 @@
+/**
+ * @file HeadlessContext.cpp
+ * @brief Windowless OpenGL context on an EGL pbuffer, libEGL loaded at run time.
+ */
+
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <dlfcn.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+
+namespace {
+
+// entry points resolved from libEGL, shared by every context (there is only ever one)
+struct EglApi {
+    decltype(&eglGetProcAddress) getProcAddress = nullptr;
+    decltype(&eglGetDisplay) getDisplay = nullptr;
+    decltype(&eglInitialize) initialize = nullptr;
+    decltype(&eglTerminate) terminate = nullptr;
+    decltype(&eglQueryString) queryString = nullptr;
+    decltype(&eglBindAPI) bindAPI = nullptr;
+    decltype(&eglChooseConfig) chooseConfig = nullptr;
+    decltype(&eglCreatePbufferSurface) createPbufferSurface = nullptr;
+    decltype(&eglDestroySurface) destroySurface = nullptr;
+    decltype(&eglCreateContext) createContext = nullptr;
+    decltype(&eglDestroyContext) destroyContext = nullptr;
+    decltype(&eglMakeCurrent) makeCurrent = nullptr;
+    decltype(&eglSwapBuffers) swapBuffers = nullptr;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = nullptr;
+};
+
+EglApi egl;
+
+template <typename Fn>
+bool Resolve(void* library, const char* name, Fn& fn) {
+    fn = reinterpret_cast<Fn>(dlsym(library, name));
+    return fn != nullptr;
+}
+
+bool HasExtension(const char* extensions, const char* name) {
+    if (!extensions) return false;
+    size_t length = std::strlen(name);
+    for (const char* at = std::strstr(extensions, name); at; at = std::strstr(at + length, name)) {
+        bool starts = at == extensions || at[-1] == ' ';
+        bool ends = at[length] == ' ' || at[length] == '\0';
+        if (starts && ends) return true;
+    }
+    return false;
+}
+
+bool Fail(std::string* error, const char* reason) {
+    if (error) *error = reason;
+    return false;
+}
+
+} // namespace
+
+
+HeadlessContext::~HeadlessContext() {
+    Destroy();
+}
+
+
+bool HeadlessContext::Create(int width, int height, std::string* error) {
+    Destroy();
+    library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!library) return Fail(error, "libEGL.so.1 not found");
+    bool resolved = Resolve(library, "eglGetProcAddress", egl.getProcAddress)
+                 && Resolve(library, "eglGetDisplay", egl.getDisplay)
+                 && Resolve(library, "eglInitialize", egl.initialize)
+                 && Resolve(library, "eglTerminate", egl.terminate)
+                 && Resolve(library, "eglQueryString", egl.queryString)
+                 && Resolve(library, "eglBindAPI", egl.bindAPI)
+                 && Resolve(library, "eglChooseConfig", egl.chooseConfig)
+                 && Resolve(library, "eglCreatePbufferSurface", egl.createPbufferSurface)
+                 && Resolve(library, "eglDestroySurface", egl.destroySurface)
+                 && Resolve(library, "eglCreateContext", egl.createContext)
+                 && Resolve(library, "eglDestroyContext", egl.destroyContext)
+                 && Resolve(library, "eglMakeCurrent", egl.makeCurrent)
+                 && Resolve(library, "eglSwapBuffers", egl.swapBuffers);
+    if (!resolved) {
+        Destroy();
+        return Fail(error, "libEGL lacks EGL 1.4 entry points");
+    }
+
+    // surfaceless needs neither a display server nor a GPU, the default display may need both
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    const char* clientExtensions = egl.queryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")
+        && HasExtension(clientExtensions, "EGL_EXT_platform_base")) {
+        egl.getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                egl.getProcAddress("eglGetPlatformDisplayEXT"));
+        if (egl.getPlatformDisplay) dpy = egl.getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (dpy == EGL_NO_DISPLAY || !egl.initialize(dpy, nullptr, nullptr)) {
+        dpy = egl.getDisplay(EGL_DEFAULT_DISPLAY);
+        if (dpy == EGL_NO_DISPLAY || !egl.initialize(dpy, nullptr, nullptr)) {
+            Destroy();
+            return Fail(error, "no EGL display could be initialized");
+        }
+    }
+    display = dpy;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!egl.bindAPI(EGL_OPENGL_API) || !egl.chooseConfig(dpy, configAttribs, &config, 1, &configCount)
+        || configCount == 0) {
+        Destroy();
+        return Fail(error, "no EGL config for desktop OpenGL pbuffers");
+    }
+
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    surface = egl.createPbufferSurface(dpy, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        surface = nullptr;
+        Destroy();
+        return Fail(error, "EGL pbuffer creation failed");
+    }
+
+    // same version and profile as the window hints
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = egl.createContext(dpy, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        context = nullptr;
+        Destroy();
+        return Fail(error, "EGL OpenGL 3.3 context creation failed");
+    }
+    if (!egl.makeCurrent(dpy, surface, surface, context)) {
+        Destroy();
+        return Fail(error, "EGL context could not be made current");
+    }
+    return true;
+}
+
+
+void HeadlessContext::SwapBuffers() {
+    if (context) egl.swapBuffers(display, surface);
+}
+
+
+void* HeadlessContext::GetProcAddress(const char* name) {
+    return egl.getProcAddress ? reinterpret_cast<void*>(egl.getProcAddress(name)) : nullptr;
+}
+
+
+void HeadlessContext::Destroy() {
+    if (display) {
+        egl.makeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context) egl.destroyContext(display, context);
+        if (surface) egl.destroySurface(display, surface);
+        egl.terminate(display);
+    }
+    context = surface = display = nullptr;
+    if (library) dlclose(library);
+    library = nullptr;
+    egl = EglApi{};
+}
@@ -0,0 +1,100 @@
+/**
+ * @file InputRecorder.cpp
+ * @brief Binary input recording and replay.
+ */
+
+#include "InputRecorder.h"
+
+#include <cstring>
+#include <iostream>
+
+
+namespace {
+
+/**
+ * @brief Header at the start of a recording file.
+ */
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t eventSize;  ///< sizeof(InputEvent), guards against layout changes
+};
+
+constexpr char MAGIC[8] = "IVSINPT";
+constexpr uint32_t VERSION = 1;
+
+static_assert(sizeof(InputEvent) == 20, "recording files store InputEvent as is");
+
+} // namespace
+
+
+bool InputRecorder::StartRecording(const std::string& path) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "failed to create input recording " << path << std::endl;
+        return false;
+    }
+
+    RecordingHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.eventSize = sizeof(InputEvent);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    mode = Mode::Record;
+    ticks = 0;
+    return true;
+}
+
+
+bool InputRecorder::StartReplay(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cerr << "failed to open input recording " << path << std::endl;
+        return false;
+    }
+    std::streamoff size = in.tellg();
+    in.seekg(0);
+
+    RecordingHeader header{};
+    if (size < static_cast<std::streamoff>(sizeof(header))
+        || !in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.version != VERSION || header.eventSize != sizeof(InputEvent)) {
+        std::cerr << "not a valid input recording: " << path << std::endl;
+        return false;
+    }
+
+    events.resize((size - sizeof(header)) / sizeof(InputEvent));
+    in.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(InputEvent));
+
+    ticks = 0;
+    for (const InputEvent& event : events) {
+        if (event.type == InputEventType::Tick) ++ticks;
+    }
+    cursor = 0;
+    mode = Mode::Replay;
+    return true;
+}
+
+
+void InputRecorder::Add(const InputEvent& event) {
+    if (mode != Mode::Record) return;
+    out.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    if (event.type == InputEventType::Tick) ++ticks;
+}
+
+
+bool InputRecorder::NextTick(InputEvent& event) {
+    // skip whatever the previous tick did not consume
+    while (cursor < events.size() && events[cursor].type != InputEventType::Tick) ++cursor;
+    if (cursor == events.size()) return false;
+    event = events[cursor++];
+    return true;
+}
+
+
+const InputEvent* InputRecorder::NextEvent() {
+    if (cursor == events.size() || events[cursor].type == InputEventType::Tick) return nullptr;
+    return &events[cursor++];
+}
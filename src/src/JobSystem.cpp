@@ -0,0 +1,111 @@
+/**
+ * @file JobSystem.cpp
+ * @brief Worker pool, main-thread upload queue and load progress.
+ */
+
+#include "JobSystem.h"
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include "ParallelFor.h"
+#include "trace.h"
+
+
+JobSystem::JobSystem(unsigned threads) {
+    if (threads == 0) threads = LoadThreadCount();
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) workers.emplace_back(&JobSystem::Work, this);
+}
+
+
+JobSystem::~JobSystem() {
+    Stop();
+}
+
+
+void JobSystem::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+
+void JobSystem::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && running == 0; });
+}
+
+
+void JobSystem::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+
+void JobSystem::Work() {
+    TRACE_THREAD_NAME("loader");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) return;
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        ++running;
+        lock.unlock();
+        try {
+            TRACE_ZONE("job");
+            job();
+        } catch (const std::exception& e) {
+            std::cerr << "Loader job failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Loader job failed" << std::endl;
+        }
+        job = nullptr;
+        lock.lock();
+        --running;
+        if (jobs.empty() && running == 0) idle.notify_all();
+    }
+}
+
+
+void UploadQueue::Push(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+}
+
+
+size_t UploadQueue::Run(double budgetMs) {
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+    size_t count = 0;
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) break;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+        ++count;
+        if (std::chrono::duration<double, std::milli>(clock::now() - start).count() >= budgetMs) break;
+    }
+    return count;
+}
+
+
+size_t UploadQueue::Pending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
@@ -0,0 +1,204 @@
+/**
+ * @file MeshCache.cpp
+ * @brief Memory-mapped binary cache of processed meshes.
+ */
+
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FileCache.h"
+
+
+namespace {
+
+// Cache file: header, vertices, indices (padded to 4 bytes), ranges, lods, materials.
+// Bump the version whenever the layout or the mesh processing changes.
+constexpr char MESH_CACHE_MAGIC[8] = "IVSMESH";
+constexpr uint32_t MESH_CACHE_VERSION = 2;
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize;     ///< sizeof(PackedVertex), guards against layout changes
+    uint64_t sourceHash;
+    uint32_t indexSize;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t rangeCount;
+    uint32_t materialCount;
+    uint32_t lodCount;
+};
+
+static_assert(sizeof(MeshCacheHeader) % 8 == 0, "sections after the header stay aligned");
+
+size_t IndexBytes(uint32_t indexCount, uint32_t indexSize) {
+    return (static_cast<size_t>(indexCount) * indexSize + 3) & ~size_t(3);
+}
+
+bool WithinIndices(uint32_t firstIndex, uint32_t count, uint32_t indexCount) {
+    return static_cast<uint64_t>(firstIndex) + count <= indexCount;
+}
+
+template <typename Index>
+bool IndicesBelow(const void* indices, uint32_t indexCount, uint32_t vertexCount) {
+    const Index* index = static_cast<const Index*>(indices);
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        if (index[i] >= vertexCount) return false;
+    }
+    return true;
+}
+
+// the tables and indices go straight into GL draws and texture lookups, a corrupt file of the right size must not
+bool TablesValid(const MeshBuffers& buffers) {
+    if (buffers.lodCount == 0) return false; // LOD 0 is what gets drawn
+    bool indicesValid = buffers.indexSize == 2
+        ? IndicesBelow<uint16_t>(buffers.indices, buffers.indexCount, buffers.vertexCount)
+        : IndicesBelow<uint32_t>(buffers.indices, buffers.indexCount, buffers.vertexCount);
+    if (!indicesValid) return false;
+    for (uint32_t i = 0; i < buffers.rangeCount; ++i) {
+        const MeshRange& range = buffers.ranges[i];
+        if (!WithinIndices(range.firstIndex, range.indexCount, buffers.indexCount)) return false;
+        if (range.material < -1 || range.material >= static_cast<int64_t>(buffers.materialCount)) return false;
+    }
+    for (uint32_t i = 0; i < buffers.lodCount; ++i) {
+        if (!WithinIndices(buffers.lods[i].firstIndex, buffers.lods[i].indexCount, buffers.indexCount)) return false;
+    }
+    for (uint32_t i = 0; i < buffers.materialCount; ++i) {
+        const MeshMaterial& material = buffers.materials[i];
+        // at most one layer per material, and the strings are terminated inside their fields
+        if (material.layer >= static_cast<int64_t>(buffers.materialCount)) return false;
+        if (!std::memchr(material.name, '\0', sizeof(material.name))
+            || !std::memchr(material.texture, '\0', sizeof(material.texture))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+MeshCache::~MeshCache() {
+    if (mapping) munmap(mapping, size);
+}
+
+
+bool MeshCache::Open(const std::string& path, uint64_t sourceHash) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(MeshCacheHeader))) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void* map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+    MeshCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    size_t vertexBytes = static_cast<size_t>(header.vertexCount) * sizeof(PackedVertex);
+    size_t indexBytes = IndexBytes(header.indexCount, header.indexSize);
+    size_t rangeBytes = static_cast<size_t>(header.rangeCount) * sizeof(MeshRange);
+    size_t lodBytes = static_cast<size_t>(header.lodCount) * sizeof(MeshLod);
+    size_t materialBytes = static_cast<size_t>(header.materialCount) * sizeof(MeshMaterial);
+    bool valid = std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0
+              && header.version == MESH_CACHE_VERSION
+              && header.vertexSize == sizeof(PackedVertex)
+              && header.sourceHash == sourceHash
+              && (header.indexSize == 2 || header.indexSize == 4)
+              && fileSize == sizeof(header) + vertexBytes + indexBytes + rangeBytes + lodBytes + materialBytes;
+    if (!valid) {
+        munmap(map, fileSize);
+        return false;
+    }
+
+    // every section is 4-byte aligned in the page-aligned mapping, used in place
+    MeshBuffers mapped;
+    const unsigned char* cursor = data + sizeof(header);
+    mapped.vertices = reinterpret_cast<const PackedVertex*>(cursor);
+    mapped.vertexCount = header.vertexCount;
+    cursor += vertexBytes;
+    mapped.indices = cursor;
+    mapped.indexCount = header.indexCount;
+    mapped.indexSize = header.indexSize;
+    cursor += indexBytes;
+    mapped.ranges = reinterpret_cast<const MeshRange*>(cursor);
+    mapped.rangeCount = header.rangeCount;
+    cursor += rangeBytes;
+    mapped.lods = reinterpret_cast<const MeshLod*>(cursor);
+    mapped.lodCount = header.lodCount;
+    cursor += lodBytes;
+    mapped.materials = reinterpret_cast<const MeshMaterial*>(cursor);
+    mapped.materialCount = header.materialCount;
+    if (!TablesValid(mapped)) {
+        munmap(map, fileSize);
+        return false;
+    }
+
+    if (mapping) munmap(mapping, size);
+    mapping = map;
+    size = fileSize;
+    buffers = mapped;
+    return true;
+}
+
+
+bool MeshCache::Write(const std::string& path, uint64_t sourceHash, const MeshBuffers& buffers) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(PackedVertex);
+    header.sourceHash = sourceHash;
+    header.indexSize = buffers.indexSize;
+    header.vertexCount = buffers.vertexCount;
+    header.indexCount = buffers.indexCount;
+    header.rangeCount = buffers.rangeCount;
+    header.materialCount = buffers.materialCount;
+    header.lodCount = buffers.lodCount;
+
+    // write next to the target and rename, so a crash never leaves a torn cache;
+    // the pid keeps instances starting together from writing into one file
+    std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        size_t indexBytes = static_cast<size_t>(buffers.indexCount) * buffers.indexSize;
+        const char padding[4] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(buffers.vertices), buffers.vertexCount * sizeof(PackedVertex));
+        out.write(static_cast<const char*>(buffers.indices), indexBytes);
+        out.write(padding, IndexBytes(buffers.indexCount, buffers.indexSize) - indexBytes);
+        out.write(reinterpret_cast<const char*>(buffers.ranges), buffers.rangeCount * sizeof(MeshRange));
+        out.write(reinterpret_cast<const char*>(buffers.lods), buffers.lodCount * sizeof(MeshLod));
+        out.write(reinterpret_cast<const char*>(buffers.materials), buffers.materialCount * sizeof(MeshMaterial));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tmpPath, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, error);
+    return !error;
+}
+
+
+std::string MeshCache::Path(uint64_t sourceHash) {
+    std::string dir = CacheDir("CALC_MESH_CACHE");
+    if (dir.empty()) return std::string();
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx.mesh", static_cast<unsigned long long>(sourceHash));
+    return dir + name;
+}
@@ -0,0 +1,522 @@
+/**
+ * @file MeshOptimizer.cpp
+ * @brief Vertex welding, vertex cache and fetch ordering, vertex quantization.
+ */
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+
+namespace {
+
+static_assert(sizeof(PackedVertex) == 24, "vertex attribute offsets assume a 24 byte vertex");
+
+constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+// Forsyth's scoring constants, tuned for a 32 entry LRU cache
+constexpr int CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRI_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+float VertexScore(int cachePosition, uint32_t remaining) {
+    if (remaining == 0) return -1.0f; // no triangles left to use it
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // used by the last triangle, fixed score so the strip does not just flip around
+            score = LAST_TRI_SCORE;
+        } else {
+            float scale = 1.0f / (CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+    // vertices with few triangles left are finished first, so they leave the cache for good
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+}
+
+// collapses that turn a triangle's normal further than this (cosine) are rejected
+constexpr double MIN_FLIP_COSINE = 0.25;
+
+// plane quadric of Garland and Heckbert: p^T A p + 2 b.p + c is the weighted sum
+// of squared distances to the accumulated planes, w the sum of their weights
+struct Quadric {
+    double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0, w = 0;
+
+    void AddPlane(double nx, double ny, double nz, double d, double weight) {
+        a00 += weight * nx * nx; a11 += weight * ny * ny; a22 += weight * nz * nz;
+        a01 += weight * nx * ny; a02 += weight * nx * nz; a12 += weight * ny * nz;
+        b0 += weight * nx * d; b1 += weight * ny * d; b2 += weight * nz * d;
+        c += weight * d * d;
+        w += weight;
+    }
+
+    void Add(const Quadric& q) {
+        a00 += q.a00; a11 += q.a11; a22 += q.a22; a01 += q.a01; a02 += q.a02; a12 += q.a12;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+    }
+
+    // mean squared distance of p to the planes
+    double Error(const float* p) const {
+        double x = p[0], y = p[1], z = p[2];
+        double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                 + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+    }
+};
+
+struct Vec3d {
+    double x, y, z;
+};
+
+Vec3d Sub(const float* a, const float* b) {
+    return { double(a[0]) - b[0], double(a[1]) - b[1], double(a[2]) - b[2] };
+}
+
+Vec3d Cross(const Vec3d& a, const Vec3d& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+double Dot(const Vec3d& a, const Vec3d& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+uint32_t HashVertex(const float* v, size_t floats) {
+    uint32_t hash = 2166136261u; // FNV-1a over the float bits
+    for (size_t i = 0; i < floats; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, &v[i], sizeof(bits));
+        hash = (hash ^ bits) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+} // namespace
+
+
+size_t WeldVertices(std::vector<float>& vertices, size_t floatsPerVertex, std::vector<uint32_t>& indices) {
+    size_t count = vertices.size() / floatsPerVertex;
+    size_t bytes = floatsPerVertex * sizeof(float);
+
+    // open addressing table of unique vertex numbers, at most half full
+    size_t tableSize = 1;
+    while (tableSize < count * 2) tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, NONE);
+    std::vector<uint32_t> remap(count);
+
+    size_t unique = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const float* v = &vertices[i * floatsPerVertex];
+        size_t slot = HashVertex(v, floatsPerVertex) & (tableSize - 1);
+        while (table[slot] != NONE
+               && std::memcmp(&vertices[table[slot] * floatsPerVertex], v, bytes) != 0) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] == NONE) {
+            // first occurrence, compact it to the front
+            if (unique != i) std::memcpy(&vertices[unique * floatsPerVertex], v, bytes);
+            table[slot] = static_cast<uint32_t>(unique++);
+        }
+        remap[i] = table[slot];
+    }
+
+    vertices.resize(unique * floatsPerVertex);
+    for (uint32_t& index : indices) index = remap[index];
+    return unique;
+}
+
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    size_t triCount = indexCount / 3;
+    if (triCount == 0) return;
+
+    // triangles using each vertex, as ranges of one adjacency array
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i) ++remaining[indices[i]];
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indexCount);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triCount; ++t) {
+        for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triScore(triCount);
+    std::vector<char> emitted(triCount, 0);
+    size_t best = 0;
+    for (size_t t = 0; t < triCount; ++t) {
+        const uint32_t* tri = indices + t * 3;
+        triScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+        if (triScore[t] > triScore[best]) best = t;
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    uint32_t cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t cursor = 0;
+
+    while (output.size() < indexCount) {
+        if (best == NONE) {
+            // dead end, no cached vertex has triangles left: take the next unused one
+            while (emitted[cursor]) ++cursor;
+            best = cursor;
+        }
+
+        const uint32_t* tri = indices + best * 3;
+        emitted[best] = 1;
+        output.insert(output.end(), tri, tri + 3);
+
+        // the triangle no longer counts for its vertices
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; ++j) {
+                if (list[j] == best) {
+                    list[j] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            --remaining[v];
+        }
+
+        // LRU: the triangle's vertices move to the front, the rest shift back
+        uint32_t next[CACHE_SIZE + 3];
+        int nextCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(next, next + nextCount, tri[k]) == next + nextCount) next[nextCount++] = tri[k];
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2]) next[nextCount++] = cache[i];
+        }
+
+        // rescore touched vertices (including the ones that fell out) and their triangles
+        for (int i = 0; i < nextCount; ++i) {
+            uint32_t v = next[i];
+            cachePosition[v] = i < CACHE_SIZE ? i : -1;
+            float score = VertexScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t j = 0; j < remaining[v]; ++j) triScore[adjacency[offsets[v] + j]] += delta;
+        }
+
+        cacheCount = std::min(nextCount, CACHE_SIZE);
+        for (int i = 0; i < cacheCount; ++i) cache[i] = next[i];
+
+        // best candidate among the triangles of cached vertices
+        best = NONE;
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            for (uint32_t j = 0; j < remaining[v]; ++j) {
+                uint32_t t = adjacency[offsets[v] + j];
+                if (triScore[t] > bestScore) {
+                    bestScore = triScore[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+
+void OptimizeVertexFetch(std::vector<float>& vertices, size_t floatsPerVertex, std::vector<uint32_t>& indices) {
+    size_t count = vertices.size() / floatsPerVertex;
+    std::vector<uint32_t> remap(count, NONE);
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == NONE) remap[index] = next++;
+        index = remap[index];
+    }
+
+    std::vector<float> reordered(static_cast<size_t>(next) * floatsPerVertex);
+    for (size_t v = 0; v < count; ++v) {
+        if (remap[v] == NONE) continue;
+        std::copy_n(&vertices[v * floatsPerVertex], floatsPerVertex, &reordered[remap[v] * floatsPerVertex]);
+    }
+    vertices.swap(reordered);
+}
+
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                    const float* vertices, size_t vertexCount, size_t floatsPerVertex,
+                    size_t targetIndexCount, float targetError, float* resultError) {
+    if (resultError) *resultError = 0.0f;
+
+    // the used vertices get dense local numbers
+    std::vector<uint32_t> local(vertexCount, NONE);
+    std::vector<uint32_t> global;
+    std::vector<uint32_t> tris(indexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& id = local[indices[i]];
+        if (id == NONE) {
+            id = static_cast<uint32_t>(global.size());
+            global.push_back(indices[i]);
+        }
+        tris[i] = id;
+    }
+    const size_t n = global.size();
+    auto pos = [&](uint32_t v) { return &vertices[static_cast<size_t>(global[v]) * floatsPerVertex]; };
+
+    // vertices with bit-identical positions form a group; a group of several is an attribute seam
+    std::vector<uint32_t> order(n), group(n), wedges(n, 0);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return std::memcmp(pos(a), pos(b), 3 * sizeof(float)) < 0;
+    });
+    for (size_t i = 0; i < n; ++i) {
+        bool same = i > 0 && std::memcmp(pos(order[i]), pos(order[i - 1]), 3 * sizeof(float)) == 0;
+        group[order[i]] = same ? group[order[i - 1]] : order[i];
+        ++wedges[group[order[i]]];
+    }
+
+    // triangles around each group, rebuilt after every pass
+    std::vector<uint32_t> offsets(n + 1), adjacency, fill(n);
+    auto buildAdjacency = [&] {
+        std::fill(offsets.begin(), offsets.end(), 0u);
+        for (uint32_t v : tris) ++offsets[group[v] + 1];
+        for (size_t g = 0; g < n; ++g) offsets[g + 1] += offsets[g];
+        adjacency.resize(tris.size());
+        std::copy(offsets.begin(), offsets.end() - 1, fill.begin());
+        for (size_t i = 0; i < tris.size(); ++i) adjacency[fill[group[tris[i]]]++] = static_cast<uint32_t>(i / 3);
+    };
+    // an open edge is used by triangles in one direction only
+    auto isBorder = [&](uint32_t ga, uint32_t gb) {
+        int forward = 0, backward = 0;
+        for (uint32_t j = offsets[ga]; j < offsets[ga + 1]; ++j) {
+            const uint32_t* tri = &tris[adjacency[j] * 3];
+            for (int k = 0; k < 3; ++k) {
+                if (group[tri[k]] != ga) continue;
+                forward += group[tri[(k + 1) % 3]] == gb;
+                backward += group[tri[(k + 2) % 3]] == gb;
+            }
+        }
+        return forward != backward;
+    };
+
+    // quadrics per group: triangle planes weighted by area, plus planes
+    // through open edges and perpendicular to their triangle, which keep outlines in place
+    std::vector<Quadric> quadrics(n);
+    buildAdjacency();
+    for (size_t t = 0; t < tris.size(); t += 3) {
+        const float* p[3] = { pos(tris[t]), pos(tris[t + 1]), pos(tris[t + 2]) };
+        Vec3d normal = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+        double length = std::sqrt(Dot(normal, normal));
+        if (length == 0.0) continue;
+        Vec3d unit = { normal.x / length, normal.y / length, normal.z / length };
+        double d = -(unit.x * p[0][0] + unit.y * p[0][1] + unit.z * p[0][2]);
+        for (int k = 0; k < 3; ++k) quadrics[group[tris[t + k]]].AddPlane(unit.x, unit.y, unit.z, d, length * 0.5);
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t ga = group[tris[t + k]], gb = group[tris[t + (k + 1) % 3]];
+            if (!isBorder(ga, gb)) continue;
+            Vec3d edge = Sub(p[(k + 1) % 3], p[k]);
+            Vec3d side = Cross(edge, unit);
+            double sideLength = std::sqrt(Dot(side, side));
+            if (sideLength == 0.0) continue;
+            side = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+            double sd = -(side.x * p[k][0] + side.y * p[k][1] + side.z * p[k][2]);
+            double weight = Dot(edge, edge);
+            quadrics[ga].AddPlane(side.x, side.y, side.z, sd, weight);
+            quadrics[gb].AddPlane(side.x, side.y, side.z, sd, weight);
+        }
+    }
+
+    enum Kind : uint8_t { MANIFOLD, BORDER, LOCKED };
+    struct Collapse {
+        uint32_t from, to;
+        double error;
+    };
+    std::vector<uint8_t> kind(n);
+    std::vector<Collapse> best(n), collapses;
+    std::vector<uint32_t> remap(n);
+    std::vector<uint8_t> touched(n);
+    const double maxError = static_cast<double>(targetError) * targetError;
+    double worst = 0.0;
+
+    while (tris.size() > targetIndexCount) {
+        for (size_t v = 0; v < n; ++v) kind[v] = wedges[group[v]] > 1 ? LOCKED : MANIFOLD;
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = tris[t + k], b = tris[t + (k + 1) % 3];
+                if (!isBorder(group[a], group[b])) continue;
+                if (kind[a] == MANIFOLD) kind[a] = BORDER;
+                if (kind[b] == MANIFOLD) kind[b] = BORDER;
+            }
+        }
+
+        // cheapest allowed half-edge collapse of every vertex, cheapest first
+        std::fill(best.begin(), best.end(), Collapse{ NONE, NONE, std::numeric_limits<double>::max() });
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = tris[t + k], b = tris[t + (k + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir, std::swap(a, b)) {
+                    if (kind[a] == LOCKED || group[a] == group[b]) continue;
+                    if (kind[a] == BORDER && !isBorder(group[a], group[b])) continue; // slide along the outline only
+                    Quadric q = quadrics[group[a]];
+                    q.Add(quadrics[group[b]]);
+                    double error = q.Error(pos(b));
+                    if (error < best[a].error) best[a] = { a, b, error };
+                }
+            }
+        }
+        collapses.clear();
+        for (const Collapse& c : best) {
+            if (c.from != NONE && c.error <= maxError) collapses.push_back(c);
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        // an interior collapse removes two triangles: do about what is left to remove,
+        // overshooting a little rather than crawling to the target with tiny passes
+        size_t limit = std::max(tris.size() - targetIndexCount, tris.size() / 64) / 6 + 1;
+        size_t done = 0;
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+        for (const Collapse& c : collapses) {
+            if (done >= limit) break;
+            uint32_t ga = group[c.from], gb = group[c.to];
+            if (touched[ga] || touched[gb]) continue;
+
+            // the triangles that stay must not flip
+            bool flips = false;
+            for (uint32_t j = offsets[ga]; j < offsets[ga + 1] && !flips; ++j) {
+                const uint32_t* tri = &tris[adjacency[j] * 3];
+                if (group[tri[0]] == gb || group[tri[1]] == gb || group[tri[2]] == gb) continue;
+                const float* p[3] = { pos(tri[0]), pos(tri[1]), pos(tri[2]) };
+                Vec3d before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+                for (int k = 0; k < 3; ++k) {
+                    if (tri[k] == c.from) p[k] = pos(c.to);
+                }
+                Vec3d after = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+                flips = Dot(before, after) <= MIN_FLIP_COSINE * std::sqrt(Dot(before, before) * Dot(after, after));
+            }
+            if (flips) continue;
+
+            remap[c.from] = c.to;
+            quadrics[gb].Add(quadrics[ga]);
+            worst = std::max(worst, c.error);
+            ++done;
+            // the neighbourhood changed, its vertices wait for the next pass
+            for (uint32_t j = offsets[ga]; j < offsets[ga + 1]; ++j) {
+                const uint32_t* tri = &tris[adjacency[j] * 3];
+                for (int k = 0; k < 3; ++k) touched[group[tri[k]]] = 1;
+            }
+        }
+        if (done == 0) break;
+
+        // apply the collapses, dropping triangles that lost an edge
+        size_t kept = 0;
+        for (size_t t = 0; t < tris.size(); t += 3) {
+            uint32_t a = remap[tris[t]], b = remap[tris[t + 1]], c = remap[tris[t + 2]];
+            if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) continue;
+            tris[kept++] = a;
+            tris[kept++] = b;
+            tris[kept++] = c;
+        }
+        tris.resize(kept);
+        buildAdjacency();
+    }
+
+    for (size_t i = 0; i < tris.size(); ++i) destination[i] = global[tris[i]];
+    if (resultError) *resultError = static_cast<float>(std::sqrt(worst));
+    return tris.size();
+}
+
+
+float AverageCacheMissRatio(const uint32_t* indices, size_t indexCount, size_t cacheSize) {
+    if (indexCount < 3) return 0.0f;
+
+    std::vector<uint32_t> fifo(cacheSize, NONE);
+    size_t head = 0;
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (std::find(fifo.begin(), fifo.end(), indices[i]) != fifo.end()) continue;
+        fifo[head] = indices[i];
+        head = (head + 1) % cacheSize;
+        ++misses;
+    }
+    return static_cast<float>(misses) / (indexCount / 3);
+}
+
+
+uint16_t FloatToHalf(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    uint32_t sign = (f >> 16) & 0x8000;
+    uint32_t biased = (f >> 23) & 0xFF;
+    uint32_t mantissa = f & 0x7FFFFF;
+
+    if (biased == 0xFF) return sign | 0x7C00 | (mantissa ? 0x200 : 0); // inf, nan
+    int exponent = static_cast<int>(biased) - 127 + 15;
+    if (exponent >= 31) return sign | 0x7C00; // too large, inf
+
+    uint32_t half, rest, halfway;
+    if (exponent <= 0) {
+        // subnormal half
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        half = mantissa >> shift;
+        rest = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    } else {
+        half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        rest = mantissa & 0x1FFF;
+        halfway = 0x1000;
+    }
+    if (rest > halfway || (rest == halfway && (half & 1))) ++half; // a carry rounds up into the exponent
+    return static_cast<uint16_t>(sign | half);
+}
+
+
+float HalfToFloat(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    if (exponent == 0) {
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    }
+    uint32_t f = exponent == 31
+        ? sign | 0x7F800000 | (mantissa << 13)
+        : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &f, sizeof(value));
+    return value;
+}
+
+
+uint32_t PackNormal(float x, float y, float z) {
+    auto snorm10 = [](float c) {
+        int v = static_cast<int>(std::lround(std::clamp(c, -1.0f, 1.0f) * 511.0f));
+        return static_cast<uint32_t>(v) & 0x3FF;
+    };
+    return snorm10(x) | (snorm10(y) << 10) | (snorm10(z) << 20);
+}
+
+
+PackedVertex PackVertex(const float* v) {
+    PackedVertex packed;
+    std::copy_n(v, 3, packed.position);
+    packed.texcoord[0] = FloatToHalf(v[3]);
+    packed.texcoord[1] = FloatToHalf(v[4]);
+    packed.normal = PackNormal(v[5], v[6], v[7]);
+    packed.layer = static_cast<int16_t>(std::lround(v[8]));
+    return packed;
+}
@@ -0,0 +1,336 @@
+/**
+ * @file ObjParser.cpp
+ * @brief Chunked parallel Wavefront .obj parser.
+ */
+
+#include "ObjParser.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+// chunks are at least this large, small files are parsed in one piece
+constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+// more chunks than threads, so a chunk full of faces does not hold up the rest
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+// components of a corner that still hold a chunk-local (relative) index
+enum : uint8_t { RELATIVE_VERTEX = 1, RELATIVE_TEXCOORD = 2, RELATIVE_NORMAL = 4 };
+
+// run of faces inside one chunk, a group that sets neither name nor
+// material continues whatever shape was open before it
+struct ChunkGroup {
+    bool setsName = false;
+    bool setsMaterial = false;
+    std::string name;
+    std::string material;
+    size_t firstCorner = 0;
+};
+
+struct RelativeCorner {
+    uint32_t corner;  ///< corner within the chunk
+    uint8_t mask;     ///< components holding a chunk-local index
+};
+
+struct Chunk {
+    std::vector<float> positions;
+    std::vector<float> texcoords;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;
+    std::vector<RelativeCorner> relative;
+    std::vector<ChunkGroup> groups;
+    std::vector<std::string> materialLibraries;
+    std::string error;
+};
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+std::string_view TrimLeft(std::string_view s) {
+    size_t i = 0;
+    while (i < s.size() && IsSpace(s[i])) ++i;
+    return s.substr(i);
+}
+
+std::string_view Trim(std::string_view s) {
+    s = TrimLeft(s);
+    while (!s.empty() && IsSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// keyword followed by whitespace, rest of the line in args
+bool Statement(std::string_view line, std::string_view keyword, std::string_view& args) {
+    if (line.size() <= keyword.size() || line.compare(0, keyword.size(), keyword) != 0) return false;
+    if (!IsSpace(line[keyword.size()])) return false;
+    args = line.substr(keyword.size() + 1);
+    return true;
+}
+
+// up to count floats from args, missing ones stay 0
+void ParseFloats(std::string_view args, float* out, int count) {
+    const char* p = args.data();
+    const char* end = p + args.size();
+    for (int i = 0; i < count; ++i) {
+        out[i] = 0.0f;
+        while (p < end && IsSpace(*p)) ++p;
+        if (p < end && *p == '+') ++p;
+        auto [next, ec] = std::from_chars(p, end, out[i]);
+        if (ec != std::errc()) out[i] = 0.0f;
+        p = next;
+        while (p < end && !IsSpace(*p)) ++p;
+    }
+}
+
+// one index of a face corner: absolute ones become zero-based, relative ones chunk-local
+bool ParseIndex(const char*& p, const char* end, size_t localCount, int32_t& index, bool& relative) {
+    int value = 0;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc() || value == 0) return false;
+    p = next;
+    relative = value < 0;
+    index = relative ? static_cast<int32_t>(localCount) + value : value - 1;
+    return true;
+}
+
+bool ParseFace(std::string_view args, Chunk& chunk, std::vector<ObjCorner>& polygon,
+               std::vector<uint8_t>& polygonMasks) {
+    polygon.clear();
+    polygonMasks.clear();
+    const char* p = args.data();
+    const char* end = p + args.size();
+    while (true) {
+        while (p < end && IsSpace(*p)) ++p;
+        if (p == end) break;
+
+        ObjCorner corner;
+        uint8_t mask = 0;
+        bool relative;
+        if (!ParseIndex(p, end, chunk.positions.size() / 3, corner.vertex, relative)) return false;
+        if (relative) mask |= RELATIVE_VERTEX;
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                if (!ParseIndex(p, end, chunk.texcoords.size() / 2, corner.texcoord, relative)) return false;
+                if (relative) mask |= RELATIVE_TEXCOORD;
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                if (!ParseIndex(p, end, chunk.normals.size() / 3, corner.normal, relative)) return false;
+                if (relative) mask |= RELATIVE_NORMAL;
+            }
+        }
+        if (p < end && !IsSpace(*p)) return false;
+        polygon.push_back(corner);
+        polygonMasks.push_back(mask);
+    }
+    if (polygon.size() < 3) return false;
+
+    // fan triangulation, fine for the convex polygons exporters write
+    for (size_t k = 2; k < polygon.size(); ++k) {
+        for (size_t c : { size_t(0), k - 1, k }) {
+            if (polygonMasks[c]) {
+                chunk.relative.push_back({ static_cast<uint32_t>(chunk.corners.size()), polygonMasks[c] });
+            }
+            chunk.corners.push_back(polygon[c]);
+        }
+    }
+    return true;
+}
+
+ChunkGroup& OpenGroup(Chunk& chunk) {
+    // a group without faces yet takes the statement itself, "o name" + "usemtl mat" make one group
+    if (chunk.groups.empty() || chunk.groups.back().firstCorner != chunk.corners.size()) {
+        chunk.groups.emplace_back();
+        chunk.groups.back().firstCorner = chunk.corners.size();
+    }
+    return chunk.groups.back();
+}
+
+void ParseChunk(std::string_view text, Chunk& chunk) {
+    chunk.groups.emplace_back(); // faces before any statement continue the previous chunk's shape
+    std::vector<ObjCorner> polygon;
+    std::vector<uint8_t> polygonMasks;
+    float values[3];
+
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t newline = text.find('\n', start);
+        if (newline == std::string_view::npos) newline = text.size();
+        std::string_view line = TrimLeft(text.substr(start, newline - start));
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::string_view args;
+        if (Statement(line, "v", args)) {
+            ParseFloats(args, values, 3);
+            chunk.positions.insert(chunk.positions.end(), values, values + 3);
+        } else if (Statement(line, "vt", args)) {
+            ParseFloats(args, values, 2);
+            chunk.texcoords.insert(chunk.texcoords.end(), values, values + 2);
+        } else if (Statement(line, "vn", args)) {
+            ParseFloats(args, values, 3);
+            chunk.normals.insert(chunk.normals.end(), values, values + 3);
+        } else if (Statement(line, "f", args)) {
+            if (!ParseFace(args, chunk, polygon, polygonMasks)) {
+                chunk.error = "malformed face: " + std::string(line);
+                return;
+            }
+        } else if (Statement(line, "o", args) || Statement(line, "g", args)) {
+            ChunkGroup& group = OpenGroup(chunk);
+            group.setsName = true;
+            group.name = Trim(args);
+        } else if (Statement(line, "usemtl", args)) {
+            ChunkGroup& group = OpenGroup(chunk);
+            group.setsMaterial = true;
+            group.material = Trim(args);
+        } else if (Statement(line, "mtllib", args)) {
+            chunk.materialLibraries.emplace_back(Trim(args));
+        }
+    }
+}
+
+} // namespace
+
+
+bool ParseObj(std::string_view text, ObjData& data, unsigned threads, std::string* error) {
+    data = ObjData{};
+    if (threads == 0) threads = LoadThreadCount();
+
+    // line-aligned chunks: each boundary moves forward to just past a newline
+    size_t chunkCount = std::clamp<size_t>(text.size() / MIN_CHUNK_BYTES, 1, threads * CHUNKS_PER_THREAD);
+    std::vector<size_t> bounds(chunkCount + 1, text.size());
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunkCount; ++c) {
+        size_t at = std::max(bounds[c - 1], text.size() * c / chunkCount);
+        size_t newline = at == 0 ? 0 : text.find('\n', at - 1);
+        bounds[c] = newline == std::string_view::npos ? text.size() : newline + 1;
+    }
+
+    std::vector<Chunk> chunks(chunkCount);
+    ParallelFor(chunkCount, [&](size_t c) {
+        ParseChunk(text.substr(bounds[c], bounds[c + 1] - bounds[c]), chunks[c]);
+    }, threads);
+
+    // prefix sums: where each chunk's attributes and corners land in the joined arrays
+    std::vector<size_t> positionBase(chunkCount + 1, 0), texcoordBase(chunkCount + 1, 0);
+    std::vector<size_t> normalBase(chunkCount + 1, 0), cornerBase(chunkCount + 1, 0);
+    for (size_t c = 0; c < chunkCount; ++c) {
+        if (!chunks[c].error.empty()) {
+            if (error) *error = chunks[c].error;
+            return false;
+        }
+        positionBase[c + 1] = positionBase[c] + chunks[c].positions.size();
+        texcoordBase[c + 1] = texcoordBase[c] + chunks[c].texcoords.size();
+        normalBase[c + 1] = normalBase[c] + chunks[c].normals.size();
+        cornerBase[c + 1] = cornerBase[c] + chunks[c].corners.size();
+        data.materialLibraries.insert(data.materialLibraries.end(),
+                                      chunks[c].materialLibraries.begin(), chunks[c].materialLibraries.end());
+    }
+    if (cornerBase[chunkCount] > UINT32_MAX) {
+        if (error) *error = "too many faces";
+        return false;
+    }
+
+    // shapes, carrying name and material across chunk boundaries
+    std::string name, material;
+    for (size_t c = 0; c < chunkCount; ++c) {
+        const Chunk& chunk = chunks[c];
+        for (size_t g = 0; g < chunk.groups.size(); ++g) {
+            const ChunkGroup& group = chunk.groups[g];
+            if (group.setsName) name = group.name;
+            if (group.setsMaterial) material = group.material;
+            size_t end = g + 1 < chunk.groups.size() ? chunk.groups[g + 1].firstCorner : chunk.corners.size();
+            if (end == group.firstCorner) continue;
+
+            uint32_t first = static_cast<uint32_t>(cornerBase[c] + group.firstCorner);
+            uint32_t count = static_cast<uint32_t>(end - group.firstCorner);
+            ObjShape* last = data.shapes.empty() ? nullptr : &data.shapes.back();
+            if (last && last->name == name && last->material == material) {
+                last->indexCount += count; // runs are contiguous, a continued shape just grows
+            } else {
+                data.shapes.push_back({ name, material, first, count });
+            }
+        }
+    }
+
+    // join the chunks in parallel, resolving relative indices and checking ranges
+    data.positions.resize(positionBase[chunkCount]);
+    data.texcoords.resize(texcoordBase[chunkCount]);
+    data.normals.resize(normalBase[chunkCount]);
+    data.corners.resize(cornerBase[chunkCount]);
+    std::vector<char> outOfRange(chunkCount, 0);
+    ParallelFor(chunkCount, [&](size_t c) {
+        Chunk& chunk = chunks[c];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + positionBase[c]);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), data.texcoords.begin() + texcoordBase[c]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + normalBase[c]);
+        for (const RelativeCorner& rel : chunk.relative) {
+            ObjCorner& corner = chunk.corners[rel.corner];
+            if (rel.mask & RELATIVE_VERTEX) corner.vertex += static_cast<int32_t>(positionBase[c] / 3);
+            if (rel.mask & RELATIVE_TEXCOORD) corner.texcoord += static_cast<int32_t>(texcoordBase[c] / 2);
+            if (rel.mask & RELATIVE_NORMAL) corner.normal += static_cast<int32_t>(normalBase[c] / 3);
+        }
+
+        const int64_t positions = static_cast<int64_t>(data.positions.size() / 3);
+        const int64_t texcoords = static_cast<int64_t>(data.texcoords.size() / 2);
+        const int64_t normals = static_cast<int64_t>(data.normals.size() / 3);
+        for (const ObjCorner& corner : chunk.corners) {
+            if (corner.vertex < 0 || corner.vertex >= positions
+                || corner.texcoord < -1 || corner.texcoord >= texcoords
+                || corner.normal < -1 || corner.normal >= normals) {
+                outOfRange[c] = 1;
+                break;
+            }
+        }
+        std::copy(chunk.corners.begin(), chunk.corners.end(), data.corners.begin() + cornerBase[c]);
+        chunk = Chunk{}; // release the chunk's memory as soon as it is copied
+    }, threads);
+
+    if (std::find(outOfRange.begin(), outOfRange.end(), 1) != outOfRange.end()) {
+        if (error) *error = "face index out of range";
+        return false;
+    }
+    return true;
+}
+
+
+bool LoadObjFile(const std::string& path, ObjData& data, unsigned threads, std::string* error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        if (error) *error = "cannot stat " + path;
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(fd);
+        data = ObjData{};
+        return true;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        if (error) *error = "cannot map " + path;
+        return false;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    bool ok = ParseObj(std::string_view(static_cast<const char*>(map), size), data, threads, error);
+    munmap(map, size);
+    return ok;
+}
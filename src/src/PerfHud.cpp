@@ -0,0 +1,230 @@
+/**
+ * @file PerfHud.cpp
+ * @brief Implementation of the CPU/GPU frame timing overlay.
+ */
+
+#include "PerfHud.h"
+#include "TextRenderer.h"
+#include "pather.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+
+
+namespace {
+
+const char* sectionNames[PerfHud::SectionCount] = { "input", "screen", "model", "skybox", "hud" };
+
+const glm::vec3 cpuColor(0.3f, 0.85f, 0.4f);
+const glm::vec3 gpuColor(1.0f, 0.6f, 0.2f);
+
+void pushQuad(std::vector<float>& out, float x, float y, float w, float h, const glm::vec3& c) {
+    const float quad[6][2] = {
+        { x, y + h }, { x, y }, { x + w, y },
+        { x, y + h }, { x + w, y }, { x + w, y + h }
+    };
+    for (const auto& v : quad) {
+        out.insert(out.end(), { v[0], v[1], c.x, c.y, c.z });
+    }
+}
+
+} // namespace
+
+
+void PerfHud::History::Push(float ms) {
+    samples[next] = ms;
+    next = (next + 1) % HISTORY;
+    if (count < HISTORY) ++count;
+}
+
+float PerfHud::History::Average() const {
+    if (count == 0) return 0.0f;
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) sum += samples[i];
+    return sum / count;
+}
+
+
+PerfHud::PerfHud() {
+    glGenQueries(QUERY_SETS * SectionCount, &queries[0][0]);
+
+    shader = ShaderProgram(pather("shaders/hud.vert").c_str(), pather("shaders/hud.frag").c_str());
+    projectionLoc = shader.Uniform("projection");
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // background + two histograms per section, 6 vertices of 5 floats per quad
+    bars.reserve((1 + SectionCount * HISTORY * 2) * 6 * 5);
+}
+
+
+void PerfHud::BeginFrame() {
+    currentSet = frameIndex % QUERY_SETS;
+
+    // results of the set issued QUERY_SETS frames ago, skipped if not ready
+    bool complete = true;
+    float gpu[SectionCount] = {};
+    for (int s = 0; s < SectionCount; ++s) {
+        if (!issued[currentSet][s]) {
+            complete = false;
+            continue;
+        }
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries[currentSet][s], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[currentSet][s], GL_QUERY_RESULT, &ns);
+            gpu[s] = ns / 1.0e6f;
+            gpuHistory[s].Push(gpu[s]);
+        } else {
+            complete = false;
+        }
+        issued[currentSet][s] = false;
+    }
+
+    if (capture.is_open() && complete) {
+        capture << frameOfSet[currentSet];
+        for (int s = 0; s < SectionCount; ++s) {
+            capture << ',' << cpuOfSet[currentSet][s] << ',' << gpu[s];
+        }
+        const RenderStats& stats = renderOfSet[currentSet];
+        capture << ',' << stats.draws << ',' << stats.Binds() << ',' << stats.skippedBinds
+                << ',' << stats.uniformUploads << ',' << stats.triangles << '\n';
+    }
+
+    frameOfSet[currentSet] = frameIndex;
+    renderOfSet[currentSet] = RenderStats{};
+    std::fill(std::begin(cpuFrame), std::end(cpuFrame), 0.0f);
+}
+
+void PerfHud::EndFrame() {
+    for (int s = 0; s < SectionCount; ++s) {
+        cpuHistory[s].Push(cpuFrame[s]);
+        cpuOfSet[currentSet][s] = cpuFrame[s];
+    }
+    ++frameIndex;
+}
+
+
+void PerfHud::Begin(Section section) {
+    sectionStart[section] = Clock::now();
+    glBeginQuery(GL_TIME_ELAPSED, queries[currentSet][section]);
+}
+
+void PerfHud::End(Section section) {
+    glEndQuery(GL_TIME_ELAPSED);
+    issued[currentSet][section] = true;
+    cpuFrame[section] += std::chrono::duration<float, std::milli>(Clock::now() - sectionStart[section]).count();
+}
+
+
+float PerfHud::Percentile(Section section, bool gpu, float p) const {
+    const History& history = gpu ? gpuHistory[section] : cpuHistory[section];
+    if (history.count == 0) return 0.0f;
+
+    float sorted[HISTORY];
+    std::copy(history.samples, history.samples + history.count, sorted);
+    int k = std::min(history.count - 1, static_cast<int>(p * history.count));
+    std::nth_element(sorted, sorted + k, sorted + history.count);
+    return sorted[k];
+}
+
+
+void PerfHud::ToggleCapture(const std::string& path) {
+    if (capture.is_open()) {
+        capture.close();
+        std::cout << "Perf capture saved to " << path << std::endl;
+        return;
+    }
+
+    capture.open(path);
+    if (!capture) {
+        std::cerr << "Failed to open perf capture file: " << path << std::endl;
+        return;
+    }
+    capture << "frame";
+    for (const char* name : sectionNames) {
+        capture << ',' << name << "_cpu_ms," << name << "_gpu_ms";
+    }
+    capture << ",draws,binds,skipped_binds,uniforms,triangles\n";
+}
+
+
+void PerfHud::Render(TextRenderer& text, float height, const glm::mat4& projection) {
+    const float panelX = 470.0f;
+    const float panelW = 320.0f;
+    const float rowH = 58.0f;
+    const float barH = 30.0f;
+    const float top = height - 10.0f;
+    const float panelH = 86.0f + rowH * static_cast<int>(SectionCount);
+
+    bars.clear();
+    pushQuad(bars, panelX, top - panelH, panelW, panelH, glm::vec3(0.05f));
+
+    float p99[SectionCount][2];
+    for (int s = 0; s < SectionCount; ++s) {
+        p99[s][0] = Percentile(static_cast<Section>(s), false, 0.99f);
+        p99[s][1] = Percentile(static_cast<Section>(s), true, 0.99f);
+
+        // bars are scaled per row so short sections stay readable
+        float scaleMs = std::max({ p99[s][0], p99[s][1], 0.5f }) * 1.2f;
+        float baseY = top - 30.0f - rowH * (s + 1) + 4.0f;
+
+        const History* histories[2] = { &cpuHistory[s], &gpuHistory[s] };
+        for (int g = 0; g < 2; ++g) {
+            const History& history = *histories[g];
+            float x0 = panelX + 10.0f + g * 155.0f;
+            for (int i = 0; i < history.count; ++i) {
+                // oldest sample on the left
+                int idx = (history.next - history.count + i + HISTORY) % HISTORY;
+                float h = std::min(history.samples[idx] / scaleMs, 1.0f) * barH;
+                pushQuad(bars, x0 + i * 1.2f, baseY, 1.0f, std::max(h, 1.0f), g ? gpuColor : cpuColor);
+            }
+        }
+    }
+
+    shader.Use();
+    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, bars.size() * sizeof(float), bars.data(), GL_STREAM_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(bars.size() / 5));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    char line[96];
+    const float scale = 0.4f;
+    std::snprintf(line, sizeof(line), "PERF  avg / p99 ms%s", capture.is_open() ? "  [REC]" : "");
+    text.AddText(line, panelX + 10.0f, top - 20.0f, scale, glm::vec3(1.0f));
+
+    for (int s = 0; s < SectionCount; ++s) {
+        float labelY = top - 30.0f - rowH * s - 14.0f;
+        std::snprintf(line, sizeof(line), "%-6s cpu %.2f / %.2f",
+                sectionNames[s], cpuHistory[s].Average(), p99[s][0]);
+        text.AddText(line, panelX + 10.0f, labelY, scale, cpuColor);
+        std::snprintf(line, sizeof(line), "gpu %.2f / %.2f", gpuHistory[s].Average(), p99[s][1]);
+        text.AddText(line, panelX + 165.0f, labelY, scale, gpuColor);
+    }
+
+    std::snprintf(line, sizeof(line), "draws %u  binds %u (+%u skipped)  uniforms %u",
+            renderStats.draws, renderStats.Binds(), renderStats.skippedBinds, renderStats.uniformUploads);
+    text.AddText(line, panelX + 10.0f, top - panelH + 44.0f, scale, glm::vec3(1.0f));
+    std::snprintf(line, sizeof(line), "triangles %u", renderStats.triangles);
+    text.AddText(line, panelX + 10.0f, top - panelH + 26.0f, scale, glm::vec3(1.0f));
+
+    std::snprintf(line, sizeof(line), "heap allocs/frame %llu (%llu B)",
+            static_cast<unsigned long long>(allocCount), static_cast<unsigned long long>(allocBytes));
+    text.AddText(line, panelX + 10.0f, top - panelH + 8.0f, scale,
+            allocCount ? glm::vec3(1.0f, 0.3f, 0.3f) : glm::vec3(1.0f));
+}
@@ -0,0 +1,146 @@
+/**
+ * @file RenderQueue.cpp
+ * @brief Sorted draw queue and redundant GL bind elimination.
+ */
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+
+void GLStateCache::BeginFrame() {
+    stats = RenderStats{};
+    Invalidate();
+}
+
+
+void GLStateCache::Invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    activeUnit = UNKNOWN;
+    std::fill(std::begin(textures), std::end(textures), UNKNOWN);
+    std::fill(std::begin(targets), std::end(targets), 0);
+}
+
+
+void GLStateCache::UseProgram(GLuint id) {
+    if (program == id) {
+        ++stats.skippedBinds;
+        return;
+    }
+    glUseProgram(id);
+    program = id;
+    ++stats.programBinds;
+}
+
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if (textures[unit] == texture && targets[unit] == target) {
+        ++stats.skippedBinds;
+        return;
+    }
+    if (activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    textures[unit] = texture;
+    targets[unit] = target;
+    ++stats.textureBinds;
+}
+
+
+void GLStateCache::BindVertexArray(GLuint id) {
+    if (vao == id) {
+        ++stats.skippedBinds;
+        return;
+    }
+    glBindVertexArray(id);
+    vao = id;
+    ++stats.vaoBinds;
+}
+
+
+void GLStateCache::UniformMatrix4(GLint location, const glm::mat4& value) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    ++stats.uniformUploads;
+}
+
+
+void GLStateCache::DrawElements(GLenum mode, GLsizei count, GLenum type, GLuint first) {
+    size_t offset = static_cast<size_t>(first) * (type == GL_UNSIGNED_SHORT ? 2 : 4);
+    glDrawElements(mode, count, type, reinterpret_cast<const void*>(offset));
+    ++stats.draws;
+    if (mode == GL_TRIANGLES) stats.triangles += count / 3;
+}
+
+
+void GLStateCache::DrawArrays(GLenum mode, GLint first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+    ++stats.draws;
+    if (mode == GL_TRIANGLES) stats.triangles += count / 3;
+}
+
+
+uint64_t RenderQueue::SortKey(RenderPass pass, GLuint program, GLuint texture, GLuint vao) {
+    // 4 bits pass | 12 bits program | 24 bits texture | 24 bits vao, larger IDs only cost batching
+    return (static_cast<uint64_t>(pass) << 60)
+        | (static_cast<uint64_t>(program & 0xFFF) << 48)
+        | (static_cast<uint64_t>(texture & 0xFFFFFF) << 24)
+        | static_cast<uint64_t>(vao & 0xFFFFFF);
+}
+
+
+void RenderQueue::Clear() {
+    packets.clear();
+    sorted = true;
+    modelUploads.clear();
+}
+
+
+void RenderQueue::Submit(const DrawPacket& packet) {
+    packets.push_back(packet);
+    DrawPacket& queued = packets.back();
+    queued.key = SortKey(packet.pass, packet.program, packet.texture, packet.vao);
+    sorted = false;
+}
+
+
+void RenderQueue::Execute(GLStateCache& gl, RenderPass pass) {
+    if (!sorted) {
+        std::sort(packets.begin(), packets.end(),
+                  [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+        sorted = true;
+    }
+
+    // packets of one pass are contiguous, the pass is the top of the key
+    uint64_t first = SortKey(pass, 0, 0, 0);
+    auto it = std::partition_point(packets.begin(), packets.end(),
+                                   [first](const DrawPacket& p) { return p.key < first; });
+
+    for (; it != packets.end() && it->pass == pass; ++it) {
+        const DrawPacket& p = *it;
+        gl.UseProgram(p.program);
+        if (p.modelLoc >= 0) {
+            auto upload = std::find_if(modelUploads.begin(), modelUploads.end(), [&p](const ModelUpload& u) {
+                return u.program == p.program && u.location == p.modelLoc;
+            });
+            if (upload == modelUploads.end()) {
+                modelUploads.push_back({ p.program, p.modelLoc, p.model });
+                gl.UniformMatrix4(p.modelLoc, p.model);
+            } else if (upload->model != p.model) {
+                upload->model = p.model;
+                gl.UniformMatrix4(p.modelLoc, p.model);
+            }
+        }
+        if (p.screenTexture) gl.BindTexture(1, GL_TEXTURE_2D, p.screenTexture);
+        gl.BindTexture(0, p.textureTarget, p.texture); // last, so unit 0 stays active for direct binds
+        gl.BindVertexArray(p.vao);
+        if (p.indexed) {
+            gl.DrawElements(p.mode, p.count, p.indexType, p.first);
+        } else {
+            gl.DrawArrays(p.mode, static_cast<GLint>(p.first), p.count);
+        }
+    }
+}
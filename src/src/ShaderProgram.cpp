@@ -0,0 +1,102 @@
+/**
+ * @file ShaderProgram.cpp
+ * @brief Shader programs with cached uniform locations and uniform buffers.
+ */
+
+#include "ShaderProgram.h"
+
+#include <fstream>
+#include <sstream>
+#include "trace.h"
+
+
+namespace {
+
+std::string LoadSource(const char* path) {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+GLuint CompileShader(GLenum type, const char* path) {
+    std::string code = LoadSource(path);
+    const char* source = code.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+GLuint LinkProgram(const char* vertexPath, const char* fragmentPath) {
+    TRACE_ZONE("shader program link");
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexPath);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentPath);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    // the program keeps what it needs, the shader objects can go
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+} // namespace
+
+
+ShaderProgram::ShaderProgram(const char* vertexPath, const char* fragmentPath)
+    : id(LinkProgram(vertexPath, fragmentPath)) {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    uniforms.reserve(count);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, i, maxLength, &length, &size, &type, name.data());
+
+        std::string uniform(name.data(), length);
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+            uniform.resize(uniform.size() - 3); // arrays are reported as "name[0]"
+        }
+        // block members are active uniforms too but have no location
+        GLint location = glGetUniformLocation(id, uniform.c_str());
+        if (location >= 0) uniforms.emplace_back(std::move(uniform), location);
+    }
+}
+
+
+GLint ShaderProgram::Uniform(std::string_view name) const {
+    for (const auto& [uniform, location] : uniforms) {
+        if (uniform == name) return location;
+    }
+    return -1;
+}
+
+
+void ShaderProgram::BindBlock(const char* blockName, GLuint binding) const {
+    GLuint index = glGetUniformBlockIndex(id, blockName);
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(id, index, binding);
+}
+
+
+UniformBuffer::UniformBuffer(GLuint binding, size_t size) : size(size) {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+}
+
+
+void UniformBuffer::Update(const void* data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file TextLayout.cpp
+ * @brief Single-pass line breaking and truncation of display text.
+ */
+
+#include "TextLayout.h"
+#include "TextRenderer.h"
+
+#include <algorithm>
+
+static constexpr std::string_view ELLIPSIS = "\xE2\x80\xA6"; // U+2026 in UTF-8
+
+
+bool TextLayout::Wrap(TextRenderer& renderer, std::string_view text, float scale, float maxWidth, int maxLines) {
+    if (Cached(Mode::Wrap, text, scale, 0.0f, maxWidth, maxLines)) return false;
+
+    layoutScale = scale;
+    lineCount = 0;
+    LayoutLine* line = &NewLine();
+
+    for (size_t i = 0; i < text.size();) {
+        size_t start = i;
+        float advance = renderer.GlyphAdvance(NextCodepoint(text, i), scale);
+
+        // a glyph wider than the box still gets a line of its own
+        if (line->width + advance > maxWidth && !line->text.empty()) {
+            if (static_cast<int>(lineCount) < maxLines) {
+                line = &NewLine();
+            }
+            else {
+                // out of lines: drop trailing characters until the ellipsis fits
+                float ellipsisWidth = renderer.CalculateTextWidth(ELLIPSIS, scale);
+                while (!line->text.empty() && line->width + ellipsisWidth > maxWidth) {
+                    size_t last = line->text.size() - 1;
+                    while (last > 0 && (static_cast<unsigned char>(line->text[last]) & 0xC0) == 0x80) --last;
+                    size_t pos = last;
+                    line->width -= renderer.GlyphAdvance(NextCodepoint(line->text, pos), scale);
+                    line->text.erase(last);
+                }
+                line->text += ELLIPSIS;
+                line->width += ellipsisWidth;
+                break;
+            }
+        }
+        line->text.append(text, start, i - start);
+        line->width += advance;
+    }
+
+    if (line->text.empty()) --lineCount; // empty text has no lines
+    Align(maxWidth);
+    return true;
+}
+
+
+bool TextLayout::FitLine(TextRenderer& renderer, std::string_view text, float scale, float minScale, float maxWidth) {
+    if (Cached(Mode::FitLine, text, scale, minScale, maxWidth, 1)) return false;
+
+    lineCount = 0;
+    LayoutLine& line = NewLine();
+
+    // advances scale linearly, so one measurement at scale 1 serves every scale
+    float unscaled = renderer.CalculateTextWidth(text, 1.0f);
+    layoutScale = scale;
+    if (unscaled * scale > maxWidth) {
+        layoutScale = std::max(minScale, maxWidth / unscaled);
+    }
+
+    float width = unscaled * layoutScale;
+    if (width <= maxWidth) {
+        line.text.assign(text);
+        line.width = width;
+        Align(maxWidth);
+        return true;
+    }
+
+    // still too wide: cut leading characters, keeping the sign in front
+    std::string_view sign, body = text;
+    if (!body.empty() && body[0] == '-') {
+        sign = body.substr(0, 1);
+        body.remove_prefix(1);
+    }
+    float prefixWidth = renderer.CalculateTextWidth(sign, layoutScale)
+                      + renderer.CalculateTextWidth(ELLIPSIS, layoutScale);
+    float remaining = width - renderer.CalculateTextWidth(sign, layoutScale);
+
+    size_t cut = 0;
+    while (remaining + prefixWidth > maxWidth) {
+        size_t next = cut;
+        char32_t codepoint = NextCodepoint(body, next);
+        if (next >= body.size()) break; // always keep the last character
+        remaining -= renderer.GlyphAdvance(codepoint, layoutScale);
+        cut = next;
+    }
+
+    line.text.assign(sign);
+    line.text += ELLIPSIS;
+    line.text.append(body.substr(cut));
+    line.width = prefixWidth + remaining;
+    Align(maxWidth);
+    return true;
+}
+
+
+bool TextLayout::Cached(Mode mode, std::string_view text, float scale, float minScale, float maxWidth, int maxLines) {
+    if (valid && keyMode == mode && keyScale == scale && keyMinScale == minScale
+        && keyWidth == maxWidth && keyLines == maxLines && keyText == text) {
+        return true;
+    }
+
+    valid = true;
+    keyMode = mode;
+    keyText.assign(text);
+    keyScale = scale;
+    keyMinScale = minScale;
+    keyWidth = maxWidth;
+    keyLines = maxLines;
+    return false;
+}
+
+
+LayoutLine& TextLayout::NewLine() {
+    if (lineCount == lines.size()) lines.emplace_back();
+    LayoutLine& line = lines[lineCount++];
+    line.text.clear();
+    line.width = 0.0f;
+    line.x = 0.0f;
+    return line;
+}
+
+
+void TextLayout::Align(float maxWidth) {
+    for (size_t i = 0; i < lineCount; ++i) {
+        lines[i].x = maxWidth - lines[i].width;
+    }
+}
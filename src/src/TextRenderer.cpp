@@ -10,124 +10,493 @@
 #include <GLFW/glfw3.h>
 
 #include "TextRenderer.h"
+#include "GlyphAtlas.h"
+#include "FileCache.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "pather.h"
+#include FT_MODULE_H
+
+// FT_RENDER_MODE_SDF appeared in FreeType 2.11; older versions fall back to coverage bitmaps
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define TEXT_SDF_GLYPHS 1
+#endif
+
+// Distance range (in pixels at load size) stored around each SDF glyph.
+// Also the headroom for outlines/smoothing when the text is magnified.
+static constexpr FT_Int SDF_SPREAD = 8;
+
+// Atlas cache file: header, glyph records, shelves, then the atlas pixels.
+// Bump the version whenever the layout or the rasterization changes.
+static constexpr char ATLAS_CACHE_MAGIC[8] = "IVSATLS";
+static constexpr uint32_t ATLAS_CACHE_VERSION = 2;
+
+struct AtlasCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t freetypeVersion;   ///< glyphs are only valid for the FreeType that rendered them
+    uint64_t fontHash;
+    uint32_t fontSize;
+    uint32_t sdfSpread;         ///< 0 for coverage bitmaps
+    uint32_t atlasWidth, atlasHeight;
+    uint32_t fallback;          ///< codepoint of the fallback glyph
+    uint32_t glyphCount;
+    uint32_t shelfCount;
+    int32_t nextShelfY;
+};
+
+struct AtlasCacheGlyph {
+    uint32_t codepoint;
+    Character glyph;
+};
+
+static constexpr uint32_t FREETYPE_VERSION_NUMBER = FREETYPE_MAJOR * 10000 + FREETYPE_MINOR * 100 + FREETYPE_PATCH;
+
+
+/**
+ * @brief Checks that cached shelves lie in the atlas and every glyph in its shelf.
+ *
+ * Glyph shelves index the LRU table and glyph rects are sampled as is, so a
+ * corrupt cache file of the right size must not get past this.
+ */
+static bool atlasCacheTablesValid(const std::vector<AtlasCacheGlyph>& glyphs,
+                                  const std::vector<GlyphAtlas::Shelf>& shelves,
+                                  int nextShelfY, int width, int height) {
+    if (nextShelfY < 0 || nextShelfY > height) return false;
+    for (const GlyphAtlas::Shelf& shelf : shelves) {
+        if (shelf.y < 0 || shelf.height < 0 || shelf.y + shelf.height > nextShelfY) return false;
+        if (shelf.x < 0 || shelf.x > width) return false;
+    }
+    for (const AtlasCacheGlyph& record : glyphs) {
+        int shelf = record.glyph.shelf;
+        if (shelf == -1) continue;
+        if (shelf < 0 || shelf >= static_cast<int>(shelves.size())) return false;
+        // back from texture coordinates to the packed pixel rect
+        long x0 = std::lround(record.glyph.uvMin.x * width), y0 = std::lround(record.glyph.uvMin.y * height);
+        long x1 = std::lround(record.glyph.uvMax.x * width), y1 = std::lround(record.glyph.uvMax.y * height);
+        const GlyphAtlas::Shelf& bounds = shelves[shelf];
+        if (x0 < 0 || x1 < x0 || x1 > width) return false;
+        if (y0 < bounds.y || y1 < y0 || y1 > bounds.y + bounds.height) return false;
+    }
+    return true;
+}
 
 
 extern std::string loadShaderSource(const char* path);
-extern GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
+
+
+/**
+ * @brief Creates a VAO/VBO pair with the text vertex layout (x, y, u, v, r, g, b).
+ */
+static void createTextBuffers(GLuint& vao, GLuint& vbo, size_t bytes, GLenum usage) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, NULL, usage);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), 0);                         // pos + uv
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(4 * sizeof(float))); // color
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
 
 
 
 TextRenderer::TextRenderer(unsigned int width, unsigned int height) {
     // Compile and setup the shader
-    shaderID = createShaderProgram(pather("shaders/text.vert").c_str(), pather("shaders/text.frag").c_str());
+    shader = ShaderProgram(pather("shaders/text.vert").c_str(), pather("shaders/text.frag").c_str());
+    projectionLoc = shader.Uniform("projection");
 
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width),
                                   static_cast<float>(height), 0.0f); // flip Y
 
-    glUseProgram(shaderID);
-    glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, &projection[0][0]);
+    SetProjection(projection);
 
-    // Configure VAO/VBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // room for 2048 glyphs (6 vertices of 7 floats each) before the queue has to grow
+    batch.reserve(2048 * 6 * 7);
+    vboCapacity = batch.capacity() * sizeof(float);
+
+    // Configure VAO/VBO: one streamed buffer for AddText(), one for retained text
+    createTextBuffers(VAO, VBO, vboCapacity, GL_STREAM_DRAW);
+    createTextBuffers(staticVAO, staticVBO, 0, GL_STATIC_DRAW);
 }
 
 
-void TextRenderer::Load(const std::string& fontPath, unsigned int fontSize) {
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
+TextRenderer::~TextRenderer() {
+    if (face) FT_Done_Face(face);
+    if (ft) FT_Done_FreeType(ft);
+}
+
+
+char32_t NextCodepoint(std::string_view text, size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i++]);
+    if (lead < 0x80) return lead;
+
+    int extra;
+    char32_t cp;
+    if ((lead & 0xE0) == 0xC0)      { extra = 1; cp = lead & 0x1F; }
+    else if ((lead & 0xF0) == 0xE0) { extra = 2; cp = lead & 0x0F; }
+    else if ((lead & 0xF8) == 0xF0) { extra = 3; cp = lead & 0x07; }
+    else return 0xFFFD;
+
+    if (i + extra > text.size()) return 0xFFFD;
+    for (int k = 0; k < extra; ++k) {
+        unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    i += extra;
+    return cp;
+}
+
+
+void TextRenderer::Load(const std::string& path, unsigned int size) {
+    if (face) { FT_Done_Face(face); face = nullptr; }
+    fontPath = path;
+    fontSize = size;
+#ifdef TEXT_SDF_GLYPHS
+    sdfGlyphs = true;
+#endif
+
+    atlas.Clear();
+    Characters.clear();
+    shelfLastUse.clear();
+    fallback = {};
+    fallback.shelf = -1;
+
+    // the cache is keyed by font contents, size and glyph mode
+    std::string cachePath;
+    std::string cacheDir = CacheDir("CALC_FONT_CACHE");
+    fontHash = HashFile(fontPath);
+    if (!cacheDir.empty() && fontHash) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/%016llx-%u-%s.atlas",
+                      static_cast<unsigned long long>(fontHash), fontSize, sdfGlyphs ? "sdf" : "cov");
+        cachePath = cacheDir + name;
+    }
+
+    // a cache hit restores the warmed-up atlas without touching FreeType
+    bool cached = !cachePath.empty() && LoadAtlasCache(cachePath);
+    if (!cached) {
+        if (!OpenFace()) return;
+
+        // the fallback glyph is cached under its own codepoint, so the atlas cache keeps it too
+        fallbackChar = FT_Get_Char_Index(face, 0xFFFD) ? 0xFFFD : U'?';
+        Glyph(fallbackChar);
+        ResolveFallback();
+
+        // printable ASCII is needed on the first frame anyway, the ellipsis as
+        // soon as the display overflows
+        for (char32_t c = 0; c < 128; ++c) Glyph(c);
+        Glyph(0x2026);
+    }
+
+    // ASCII advances go to a flat table so measuring never touches the glyph cache
+    for (char32_t c = 0; c < 128; ++c) {
+        asciiAdvance[c] = static_cast<float>(Glyph(c).advance >> 6);
+    }
+
+    // upload the whole atlas as one texture, later glyphs update it in place
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
+    if (!atlasTexture) glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.Width(), atlas.Height(), 0,
+                 GL_RED, GL_UNSIGNED_BYTE, atlas.Pixels());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    shader.Use();
+    glUniform1i(shader.Uniform("sdf"), sdfGlyphs);
+
+    if (!cached && !cachePath.empty()) SaveAtlasCache(cachePath);
+}
+
+
+bool TextRenderer::OpenFace() {
+    if (face) return true;
+    if (fontPath.empty()) return false;
+
+    if (!ft && FT_Init_FreeType(&ft)) {
+        ft = nullptr;
+        fontPath.clear(); // report once, not on every glyph miss
         std::cerr << "FREETYPE: Failed to init FreeType" << std::endl;
-        return;
+        return false;
     }
 
-    FT_Face face;
     if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+        face = nullptr;
         std::cerr << "FREETYPE: Failed to load font " << fontPath << std::endl;
-        return;
+        fontPath.clear();
+        return false;
     }
 
-    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
-    std::cerr << "FREETYPE: Failed to load font " << fontPath << std::endl;
-    FT_Done_FreeType(ft);
-    return;
+    FT_Set_Pixel_Sizes(face, 0, fontSize);
+#ifdef TEXT_SDF_GLYPHS
+    FT_Int spread = SDF_SPREAD;
+    FT_Property_Set(ft, "sdf", "spread", &spread);
+#endif
+    return true;
 }
 
 
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
+bool TextRenderer::LoadAtlasCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(AtlasCacheHeader))) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const unsigned char* data = static_cast<const unsigned char*>(mapping);
+    AtlasCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    size_t glyphBytes = static_cast<size_t>(header.glyphCount) * sizeof(AtlasCacheGlyph);
+    size_t shelfBytes = static_cast<size_t>(header.shelfCount) * sizeof(GlyphAtlas::Shelf);
+    size_t pixelBytes = static_cast<size_t>(atlas.Width()) * atlas.Height();
+    bool valid = std::memcmp(header.magic, ATLAS_CACHE_MAGIC, sizeof(header.magic)) == 0
+              && header.version == ATLAS_CACHE_VERSION
+              && header.freetypeVersion == FREETYPE_VERSION_NUMBER
+              && header.fontHash == fontHash
+              && header.fontSize == fontSize
+              && header.sdfSpread == (sdfGlyphs ? static_cast<uint32_t>(SDF_SPREAD) : 0u)
+              && header.atlasWidth == static_cast<uint32_t>(atlas.Width())
+              && header.atlasHeight == static_cast<uint32_t>(atlas.Height())
+              && fileSize == sizeof(header) + glyphBytes + shelfBytes + pixelBytes;
+
+    std::vector<AtlasCacheGlyph> glyphs;
+    std::vector<GlyphAtlas::Shelf> shelves;
+    const unsigned char* cursor = data + sizeof(header);
+    if (valid) {
+        glyphs.resize(header.glyphCount);
+        std::memcpy(glyphs.data(), cursor, glyphBytes);
+        shelves.resize(header.shelfCount);
+        std::memcpy(shelves.data(), cursor + glyphBytes, shelfBytes);
+        valid = atlasCacheTablesValid(glyphs, shelves, header.nextShelfY, atlas.Width(), atlas.Height());
+    }
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
+    // anything inconsistent is a miss, the atlas is rebuilt from the font
+    if (valid) {
+        Characters.reserve(header.glyphCount);
+        for (const AtlasCacheGlyph& record : glyphs) {
+            Characters.emplace(static_cast<char32_t>(record.codepoint), record.glyph);
+        }
+        atlas.Restore(shelves.data(), static_cast<int>(shelves.size()), header.nextShelfY, cursor + glyphBytes + shelfBytes);
+        shelfLastUse.assign(header.shelfCount, 0);
+
+        fallbackChar = header.fallback;
+        ResolveFallback();
+    }
+
+    munmap(mapping, fileSize);
+    return valid;
+}
+
+
+void TextRenderer::SaveAtlasCache(const std::string& path) const {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    AtlasCacheHeader header{};
+    std::memcpy(header.magic, ATLAS_CACHE_MAGIC, sizeof(header.magic));
+    header.version = ATLAS_CACHE_VERSION;
+    header.freetypeVersion = FREETYPE_VERSION_NUMBER;
+    header.fontHash = fontHash;
+    header.fontSize = fontSize;
+    header.sdfSpread = sdfGlyphs ? SDF_SPREAD : 0;
+    header.atlasWidth = atlas.Width();
+    header.atlasHeight = atlas.Height();
+    header.fallback = fallbackChar;
+    header.glyphCount = static_cast<uint32_t>(Characters.size());
+    header.shelfCount = static_cast<uint32_t>(atlas.Shelves().size());
+    header.nextShelfY = atlas.NextShelfY();
+
+    // write next to the target and rename, so a crash never leaves a torn cache;
+    // the pid keeps instances starting together from writing into one file
+    std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& [codepoint, glyph] : Characters) {
+            AtlasCacheGlyph record{ static_cast<uint32_t>(codepoint), glyph };
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        out.write(reinterpret_cast<const char*>(atlas.Shelves().data()), header.shelfCount * sizeof(GlyphAtlas::Shelf));
+        out.write(reinterpret_cast<const char*>(atlas.Pixels()), static_cast<std::streamsize>(atlas.Width()) * atlas.Height());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tmpPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, error);
+}
+
+
+void TextRenderer::ResolveFallback() {
+    auto it = Characters.find(fallbackChar);
+    if (it != Characters.end()) {
+        fallback = it->second;
+    } else {
+        fallback = {};
+        fallback.shelf = -1; // nothing to draw, and no shelf to pin
+    }
+    // the fallback glyph's shelf is pinned so it can never be evicted
+    if (fallback.shelf >= 0) shelfLastUse[fallback.shelf] = UINT64_MAX;
+}
+
+
+const Character& TextRenderer::Glyph(char32_t codepoint) {
+    auto it = Characters.find(codepoint);
+    if (it == Characters.end()) {
+        Character ch;
+        // atlas full of glyphs the pending batch still needs: draw the fallback, retry next time
+        if (!Rasterize(codepoint, ch)) return fallback;
+        it = Characters.emplace(codepoint, ch).first;
+    }
+    int shelf = it->second.shelf;
+    if (shelf >= 0) shelfLastUse[shelf] = std::max(shelfLastUse[shelf], generation);
+    return it->second;
+}
+
+
+bool TextRenderer::Rasterize(char32_t codepoint, Character& out) {
+    // after a cache hit the face is only opened once a glyph is missing from the cache
+    FT_UInt index = OpenFace() ? FT_Get_Char_Index(face, codepoint) : 0;
+    if (index == 0) {
+        out = fallback; // cached under the missing codepoint, so it is looked up once
+        return true;
+    }
+
+#ifdef TEXT_SDF_GLYPHS
+    const FT_Render_Mode renderMode = sdfGlyphs ? FT_RENDER_MODE_SDF : FT_RENDER_MODE_NORMAL;
+#else
+    const FT_Render_Mode renderMode = FT_RENDER_MODE_NORMAL;
+#endif
+    // the SDF bitmap is grown by the spread on every side and bitmap_left/top
+    // already account for it, so the quad math in AddText stays the same
+    if (FT_Load_Glyph(face, index, FT_LOAD_DEFAULT) || FT_Render_Glyph(face->glyph, renderMode)) {
+        out = fallback;
+        return true;
+    }
+
+    const FT_Bitmap& bitmap = face->glyph->bitmap;
+    int w = static_cast<int>(bitmap.width);
+    int h = static_cast<int>(bitmap.rows);
+    AtlasRect rect;
+    if (w > 0 && h > 0) {
+        if (!atlas.Pack(w, h, rect) && !(EvictShelf(w, h) && atlas.Pack(w, h, rect))) {
+            return false;
+        }
+        atlas.Blit(rect, bitmap.buffer, bitmap.pitch);
+        UploadRect(rect);
+        if (rect.shelf >= static_cast<int>(shelfLastUse.size())) shelfLastUse.resize(rect.shelf + 1, 0);
+    }
+
+    out = {
+        glm::vec2(static_cast<float>(rect.x) / atlas.Width(), static_cast<float>(rect.y) / atlas.Height()),
+        glm::vec2(static_cast<float>(rect.x + rect.w) / atlas.Width(), static_cast<float>(rect.y + rect.h) / atlas.Height()),
+        glm::ivec2(w, h),
+        glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
+        static_cast<unsigned int>(face->glyph->advance.x),
+        rect.shelf
+    };
+    return true;
+}
 
-    for (unsigned char c = 0; c < 128; ++c) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) continue;
-
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D, 0, GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0, GL_RED, GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<unsigned int>(face->glyph->advance.x)
-        };
-        Characters[c] = character;
 
+bool TextRenderer::EvictShelf(int w, int h) {
+    int victim = -1;
+    for (int i = 0; i < atlas.ShelfCount(); ++i) {
+        // glyphs queued since the last Flush() still point at their shelf
+        if (shelfLastUse[i] >= generation || !atlas.ShelfFits(i, w, h)) continue;
+        if (victim < 0 || shelfLastUse[i] < shelfLastUse[victim]) victim = i;
     }
+    if (victim < 0) return false;
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    for (auto it = Characters.begin(); it != Characters.end();) {
+        if (it->second.shelf == victim) it = Characters.erase(it);
+        else ++it;
+    }
+    atlas.ClearShelf(victim);
+    UploadRect(atlas.ShelfBounds(victim)); // no stale texels next to the new glyphs
+    shelfLastUse[victim] = 0;
+    ++atlasEpoch; // retained text may use the evicted glyphs
+
+    return true;
 }
 
 
+void TextRenderer::UploadRect(const AtlasRect& rect) {
+    if (!atlasTexture) return; // during Load() the whole atlas is uploaded at the end
+
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, atlas.Width());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_RED, GL_UNSIGNED_BYTE,
+                    atlas.Pixels() + static_cast<size_t>(rect.y) * atlas.Width() + rect.x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-float TextRenderer::CalculateTextWidth(const std::string& text, float scale)
+
+
+float TextRenderer::CalculateTextWidth(std::string_view text, float scale)
 {
     float width = 0.0f;
-    for (char c : text) {
-        if (Characters.count(c)) {
-            width += (Characters[c].advance >> 6) * scale; // advance is in 1/64 pixels
-        }
+    for (size_t i = 0; i < text.size();) {
+        width += GlyphAdvance(NextCodepoint(text, i), scale);
     }
     return width;
 }
 
-void TextRenderer::RenderText(const std::string& text, float x, float y, float scale, glm::vec3 color) {
-    glUseProgram(shaderID);
-    glUniform3f(glGetUniformLocation(shaderID, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
+float TextRenderer::GlyphAdvance(char32_t codepoint, float scale)
+{
+    if (codepoint < 128) return asciiAdvance[codepoint] * scale;
+    return (Glyph(codepoint).advance >> 6) * scale; // advance is in 1/64 pixels
+}
 
-    // Iterate through all characters
-    for (auto c = text.begin(); c != text.end(); ++c) {
-        if (Characters.find(*c) == Characters.end()) {
-            std::cerr << "Missing glyph for character: " << *c << std::endl;
-            continue;  // Correctly placed continue statement inside loop
-        }
+void TextRenderer::AddText(std::string_view text, float x, float y, float scale, glm::vec3 color) {
+    if (recordingStatic >= 0) {
+        StaticText& st = statics[recordingStatic];
+        size_t begin = st.chars.size();
+        st.chars.append(text);
+        st.runs.push_back({ begin, st.chars.size(), x, y, scale, color });
+        return;
+    }
+    AppendQuads(batch, text, x, y, scale, color);
+}
 
-        Character ch = Characters[*c];
+void TextRenderer::AppendQuads(std::vector<float>& out, std::string_view text, float x, float y, float scale, glm::vec3 color) {
+    // Iterate through all codepoints
+    for (size_t i = 0; i < text.size();) {
+        const Character& ch = Glyph(NextCodepoint(text, i));
+        if (ch.size.x == 0) { // space or empty glyph, nothing to draw
+            x += (ch.advance >> 6) * scale;
+            continue;
+        }
 
         float xpos = x + ch.bearing.x * scale;
         float ypos = y - (ch.size.y - ch.bearing.y) * scale;
@@ -135,27 +504,120 @@ void TextRenderer::RenderText(const std::string& text, float x, float y, float s
         float w = ch.size.x * scale;
         float h = ch.size.y * scale;
 
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+        const float vertices[6][4] = {
+            { xpos,     ypos + h,   ch.uvMin.x, ch.uvMin.y },
+            { xpos,     ypos,       ch.uvMin.x, ch.uvMax.y },
+            { xpos + w, ypos,       ch.uvMax.x, ch.uvMax.y },
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
+            { xpos,     ypos + h,   ch.uvMin.x, ch.uvMin.y },
+            { xpos + w, ypos,       ch.uvMax.x, ch.uvMax.y },
+            { xpos + w, ypos + h,   ch.uvMax.x, ch.uvMin.y }
         };
 
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        for (const auto& v : vertices) {
+            out.insert(out.end(), { v[0], v[1], v[2], v[3], color.x, color.y, color.z });
+        }
 
         x += (ch.advance >> 6) * scale;
     }
+}
 
+void TextRenderer::Flush() {
+    if (batch.empty()) return;
+
+    shader.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture); // one bind for the whole batch
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    size_t bytes = batch.size() * sizeof(float);
+    if (bytes > vboCapacity) {
+        vboCapacity = batch.capacity() * sizeof(float);
+    }
+    // orphan the old storage so the driver never waits for the previous draw
+    glBufferData(GL_ARRAY_BUFFER, vboCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.data());
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.size() / 7));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
+    batch.clear();
+    ++generation; // queued glyphs are drawn, their shelves may be evicted again
+}
+
+int TextRenderer::CreateStaticText() {
+    statics.emplace_back();
+    return static_cast<int>(statics.size()) - 1;
+}
+
+void TextRenderer::BeginStaticText(int id) {
+    statics[id].chars.clear();
+    statics[id].runs.clear();
+    recordingStatic = id;
+}
+
+void TextRenderer::EndStaticText() {
+    int id = recordingStatic;
+    recordingStatic = -1;
+    if (id >= 0) BuildStaticText(id);
 }
 
+void TextRenderer::BuildStaticText(int id) {
+    StaticText& st = statics[id];
+    staticScratch.clear();
+    for (const StaticRun& run : st.runs) {
+        std::string_view text(st.chars.data() + run.begin, run.end - run.begin);
+        AppendQuads(staticScratch, text, run.x, run.y, run.scale, run.color);
+    }
+
+    GLsizei count = static_cast<GLsizei>(staticScratch.size() / 7);
+    if (count > st.capacity) {
+        // outgrew its range: move to the end of the buffer, the old range is left unused
+        st.first = static_cast<GLint>(staticVertices.size() / 7);
+        st.capacity = count;
+        staticVertices.resize(staticVertices.size() + staticScratch.size());
+    }
+    std::copy(staticScratch.begin(), staticScratch.end(), staticVertices.begin() + st.first * 7);
+    st.count = count;
+    st.epoch = atlasEpoch;
+
+    glBindBuffer(GL_ARRAY_BUFFER, staticVBO);
+    size_t bytes = staticVertices.size() * sizeof(float);
+    if (bytes > staticVboBytes) {
+        staticVboBytes = staticVertices.capacity() * sizeof(float);
+        glBufferData(GL_ARRAY_BUFFER, staticVboBytes, NULL, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, staticVertices.data());
+    } else if (count > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, st.first * 7 * sizeof(float), count * 7 * sizeof(float),
+                        staticVertices.data() + st.first * 7);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TextRenderer::DrawStaticText(int id) {
+    StaticText& st = statics[id];
+    if (st.epoch != atlasEpoch) BuildStaticText(id); // glyphs were evicted since the last build
+    if (st.count == 0) return;
+
+    shader.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glBindVertexArray(staticVAO);
+    glDrawArrays(GL_TRIANGLES, st.first, st.count);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextRenderer::SetProjection(const glm::mat4& projection) {
+    if (projection == currentProjection) return;
+    currentProjection = projection;
+    shader.Use();
+    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+}
+
+void TextRenderer::RenderText(std::string_view text, float x, float y, float scale, glm::vec3 color) {
+    AddText(text, x, y, scale, color);
+    Flush();
+}
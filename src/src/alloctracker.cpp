@@ -0,0 +1,74 @@
+/**
+ * @file alloctracker.cpp
+ * @brief Replacement global operator new/delete with allocation counters.
+ */
+
+#include "alloctracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t thread_count = 0;
+thread_local uint64_t thread_bytes = 0;
+std::atomic<uint64_t> process_count{ 0 };
+std::atomic<uint64_t> process_bytes{ 0 };
+
+void count_allocation(std::size_t size) {
+    ++thread_count;
+    thread_bytes += size;
+    process_count.fetch_add(1, std::memory_order_relaxed);
+    process_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) {
+    count_allocation(size);
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* ptr = std::malloc(size)) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment) {
+    count_allocation(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc needs size to be a multiple of the alignment
+    std::size_t rounded = (size + align - 1) / align * align;
+    if (rounded == 0) rounded = align;
+    for (;;) {
+        if (void* ptr = std::aligned_alloc(align, rounded)) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+} // namespace
+
+AllocStats thread_alloc_stats() {
+    return { thread_count, thread_bytes };
+}
+
+AllocStats process_alloc_stats() {
+    return { process_count.load(std::memory_order_relaxed), process_bytes.load(std::memory_order_relaxed) };
+}
+
+// array and nothrow forms use these through the default library implementations
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
@@ -0,0 +1,65 @@
+//cpudispatch.cpp
+
+#include "../include/cpudispatch.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief Implementation of CPU feature check
+ */
+bool isaSupported(IsaLevel level) {
+#if defined(__x86_64__) || defined(__i386__)
+	switch (level) {
+		case IsaLevel::Baseline: return true;
+		case IsaLevel::AVX2:     return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		case IsaLevel::AVX512:   return __builtin_cpu_supports("avx512f");
+	}
+	return false;
+#else
+	return level == IsaLevel::Baseline;
+#endif
+}
+
+/**
+ * @brief Picks the best supported level, or the one forced by CALC_ISA
+ */
+static IsaLevel detectIsa() {
+	IsaLevel best = IsaLevel::Baseline;
+	if (isaSupported(IsaLevel::AVX2)) best = IsaLevel::AVX2;
+	if (isaSupported(IsaLevel::AVX512)) best = IsaLevel::AVX512;
+
+	const char* forced = std::getenv("CALC_ISA");
+	if (!forced || !*forced) return best;
+
+	for (IsaLevel level : { IsaLevel::Baseline, IsaLevel::AVX2, IsaLevel::AVX512 }) {
+		if (std::strcmp(forced, isaName(level)) == 0) {
+			if (isaSupported(level)) return level;
+			std::cerr << "CALC_ISA=" << forced << " not supported by this CPU, using " << isaName(best) << std::endl;
+			return best;
+		}
+	}
+	std::cerr << "Unknown CALC_ISA value: " << forced << std::endl;
+	return best;
+}
+
+/**
+ * @brief Implementation of active level lookup (detected once)
+ */
+IsaLevel activeIsa() {
+	static const IsaLevel level = detectIsa();
+	return level;
+}
+
+/**
+ * @brief Implementation of level naming
+ */
+const char* isaName(IsaLevel level) {
+	switch (level) {
+		case IsaLevel::Baseline: return "baseline";
+		case IsaLevel::AVX2:     return "avx2";
+		case IsaLevel::AVX512:   return "avx512";
+	}
+	return "unknown";
+}
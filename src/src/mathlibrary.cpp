@@ -2,6 +2,11 @@
 
 #include "../include/mathlibrary.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATHLIB_X86 1
+#endif
+
 /**
  * @brief Implementation of addition operation
  */
@@ -100,3 +105,97 @@ double Calculator::modulo(double a, double b) {
     if(result < 0) result += std::abs(static_cast<int>(b));
     return static_cast<double>(result);
 }
+
+/**
+ * @brief Portable sum / sum of squares kernel
+ */
+static void accumulateBaseline(const double* values, size_t count, double& sum, double& sum_squares) {
+	double s = 0.0, sq = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		s += values[i];
+		sq += values[i] * values[i];
+	}
+	sum += s;
+	sum_squares += sq;
+}
+
+#ifdef MATHLIB_X86
+/**
+ * @brief AVX2 sum / sum of squares kernel (4 doubles per step)
+ */
+__attribute__((target("avx2,fma")))
+static void accumulateAVX2(const double* values, size_t count, double& sum, double& sum_squares) {
+	__m256d s = _mm256_setzero_pd();
+	__m256d sq = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256d v = _mm256_loadu_pd(values + i);
+		s = _mm256_add_pd(s, v);
+		sq = _mm256_fmadd_pd(v, v, sq);
+	}
+	alignas(32) double ls[4], lsq[4];
+	_mm256_store_pd(ls, s);
+	_mm256_store_pd(lsq, sq);
+	double ts = (ls[0] + ls[1]) + (ls[2] + ls[3]);
+	double tsq = (lsq[0] + lsq[1]) + (lsq[2] + lsq[3]);
+	for (; i < count; i++) {
+		ts += values[i];
+		tsq += values[i] * values[i];
+	}
+	sum += ts;
+	sum_squares += tsq;
+}
+
+/**
+ * @brief AVX-512 sum / sum of squares kernel (8 doubles per step)
+ */
+__attribute__((target("avx512f")))
+static void accumulateAVX512(const double* values, size_t count, double& sum, double& sum_squares) {
+	__m512d s = _mm512_setzero_pd();
+	__m512d sq = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m512d v = _mm512_loadu_pd(values + i);
+		s = _mm512_add_pd(s, v);
+		sq = _mm512_fmadd_pd(v, v, sq);
+	}
+	double ts = _mm512_reduce_add_pd(s);
+	double tsq = _mm512_reduce_add_pd(sq);
+	for (; i < count; i++) {
+		ts += values[i];
+		tsq += values[i] * values[i];
+	}
+	sum += ts;
+	sum_squares += tsq;
+}
+#endif
+
+/**
+ * @brief Implementation of batch accumulation with an explicit kernel variant
+ */
+void Calculator::accumulate(const double* values, size_t count, double& sum, double& sum_squares, IsaLevel level) {
+	switch (level) {
+#ifdef MATHLIB_X86
+		case IsaLevel::AVX512: accumulateAVX512(values, count, sum, sum_squares); return;
+		case IsaLevel::AVX2:   accumulateAVX2(values, count, sum, sum_squares); return;
+#endif
+		default:               accumulateBaseline(values, count, sum, sum_squares); return;
+	}
+}
+
+/**
+ * @brief Implementation of batch accumulation (variant picked once at startup)
+ */
+void Calculator::accumulate(const double* values, size_t count, double& sum, double& sum_squares) {
+	using Kernel = void (*)(const double*, size_t, double&, double&);
+	static const Kernel kernel = [] () -> Kernel {
+		switch (activeIsa()) {
+#ifdef MATHLIB_X86
+			case IsaLevel::AVX512: return accumulateAVX512;
+			case IsaLevel::AVX2:   return accumulateAVX2;
+#endif
+			default:               return accumulateBaseline;
+		}
+	}();
+	kernel(values, count, sum, sum_squares);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file trace.cpp
+ * @brief Per-thread ring buffers and Chrome trace JSON export.
+ */
+
+#include "trace.h"
+
+#ifdef CALC_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+/// events kept per thread; older events are overwritten
+constexpr uint64_t RING_CAPACITY = 1 << 16;
+
+/**
+ * @brief One recorded event
+ */
+struct Event {
+    const char* name;   ///< static event name
+    uint64_t start_ns;  ///< start timestamp
+    uint64_t dur_ns;    ///< duration, 0 for instant events
+    char phase;         ///< 'X' complete or 'i' instant
+    char arg[39];       ///< optional text argument
+};
+
+/**
+ * @brief Ring buffer owned and written by a single thread
+ *
+ * The writer publishes with a release store of head, the exporter reads
+ * head with acquire, so recording never takes a lock.
+ */
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{ new Event[RING_CAPACITY] };
+    std::atomic<uint64_t> head{ 0 };
+    const char* thread_name = nullptr;
+    int tid = 0;
+};
+
+const auto trace_start = std::chrono::steady_clock::now();
+
+std::mutex registry_mutex;                            // guards registration only
+std::vector<std::unique_ptr<ThreadBuffer>> registry;  // buffers of all threads that traced
+
+ThreadBuffer& local_buffer() {
+    thread_local ThreadBuffer* buffer = [] {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::make_unique<ThreadBuffer>());
+        registry.back()->tid = static_cast<int>(registry.size());
+        return registry.back().get();
+    }();
+    return *buffer;
+}
+
+void push(const Event& event) {
+    ThreadBuffer& buffer = local_buffer();
+    uint64_t index = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[index % RING_CAPACITY] = event;
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+void write_escaped(FILE* file, const char* text) {
+    for (; *text; ++text) {
+        unsigned char c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\') std::fprintf(file, "\\%c", c);
+        else if (c < 0x20) std::fprintf(file, "\\u%04x", c);
+        else std::fputc(c, file);
+    }
+}
+
+} // namespace
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - trace_start).count();
+}
+
+void record_zone(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    Event event;
+    event.name = name;
+    event.start_ns = start_ns;
+    event.dur_ns = end_ns - start_ns;
+    event.phase = 'X';
+    event.arg[0] = '\0';
+    push(event);
+}
+
+void record_instant(const char* name, const char* arg) {
+    Event event;
+    event.name = name;
+    event.start_ns = now_ns();
+    event.dur_ns = 0;
+    event.phase = 'i';
+    event.arg[0] = '\0';
+    if (arg) {
+        std::strncpy(event.arg, arg, sizeof(event.arg) - 1);
+        event.arg[sizeof(event.arg) - 1] = '\0';
+    }
+    push(event);
+}
+
+void set_thread_name(const char* name) {
+    local_buffer().thread_name = name;
+}
+
+bool write_chrome_json(const char* path) {
+    if (!path) path = "calculator_trace.json";
+    FILE* file = std::fopen(path, "w");
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+
+    for (const auto& buffer : registry) {
+        if (buffer->thread_name) {
+            std::fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"",
+                    first ? "" : ",\n", buffer->tid);
+            write_escaped(file, buffer->thread_name);
+            std::fprintf(file, "\"}}");
+            first = false;
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const Event& event = buffer->events[i % RING_CAPACITY];
+            std::fprintf(file, "%s{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"name\":\"",
+                    first ? "" : ",\n", event.phase, buffer->tid, event.start_ns / 1000.0);
+            write_escaped(file, event.name);
+            std::fprintf(file, "\"");
+            if (event.phase == 'X') {
+                std::fprintf(file, ",\"dur\":%.3f", event.dur_ns / 1000.0);
+            } else {
+                std::fprintf(file, ",\"s\":\"t\"");
+            }
+            if (event.arg[0]) {
+                std::fprintf(file, ",\"args\":{\"value\":\"");
+                write_escaped(file, event.arg);
+                std::fprintf(file, "\"}");
+            }
+            std::fprintf(file, "}");
+            first = false;
+        }
+    }
+
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    return true;
+}
+
+} // namespace trace
+
+#endif // CALC_TRACE
@@ -4,7 +4,32 @@
  */
 
  #include <gtest/gtest.h>
+ #include <algorithm>
+ #include <array>
+ #include <vector>
  #include "../include/mathlibrary.h"
+ #include "../include/alloctracker.h"
+ #include "../include/GlyphAtlas.h"
+ #include "../include/InputRecorder.h"
+ #include "../include/SpscQueue.h"
+ #include "../include/TripleBuffer.h"
+ #include "../include/MeshOptimizer.h"
+ #include "../include/MeshCache.h"
+ #include "../include/ObjParser.h"
+ #include "../include/JobSystem.h"
+ 
+ // n x n quad grid in the unit square at z = 0: x, y, z per shared vertex, two triangles per quad facing +z
+ static void BuildQuadGrid(int n, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+     for (int y = 0; y <= n; ++y) {
+         for (int x = 0; x <= n; ++x) vertices.insert(vertices.end(), { float(x) / n, float(y) / n, 0.0f });
+     }
+     for (int y = 0; y < n; ++y) {
+         for (int x = 0; x < n; ++x) {
+             uint32_t a = y * (n + 1) + x, b = a + 1, c = a + n + 2, d = a + n + 1;
+             indices.insert(indices.end(), { a, b, c, a, c, d });
+         }
+     }
+ }
  
  TEST(CalculatorTest, Addition) {
      EXPECT_DOUBLE_EQ(10.0, Calculator::add(5.0, 5.0));
@@ -74,6 +99,378 @@
      EXPECT_FALSE(Calculator::isInteger(1e12 + 0.0001));
  }
  
+ TEST(CalculatorTest, AccumulateMatchesAllIsaLevels) {
+     std::vector<double> values;
+     for (int i = 1; i <= 1003; i++) values.push_back(i * 0.5 - 100.0);
+ 
+     double ref_sum = 0.0, ref_sq = 0.0;
+     Calculator::accumulate(values.data(), values.size(), ref_sum, ref_sq, IsaLevel::Baseline);
+     EXPECT_NEAR(151453.0, ref_sum, 1e-6);
+ 
+     for (IsaLevel level : { IsaLevel::AVX2, IsaLevel::AVX512 }) {
+         if (!isaSupported(level)) continue;
+         double sum = 1.0, sq = 2.0;
+         Calculator::accumulate(values.data(), values.size(), sum, sq, level);
+         EXPECT_NEAR(ref_sum + 1.0, sum, 1e-6) << isaName(level);
+         EXPECT_NEAR(ref_sq + 2.0, sq, 1e-6) << isaName(level);
+     }
+ 
+     double sum = 0.0, sq = 0.0;
+     Calculator::accumulate(values.data(), 3, sum, sq);
+     EXPECT_DOUBLE_EQ(-99.5 - 99.0 - 98.5, sum);
+ }
+ 
+ TEST(AllocTrackerTest, CountsAllocations) {
+     AllocScope scope;
+     std::vector<int>* values = new std::vector<int>(100);
+     delete values;
+     AllocStats stats = scope.delta();
+     EXPECT_EQ(2u, stats.count);
+     EXPECT_EQ(sizeof(std::vector<int>) + 100 * sizeof(int), stats.bytes);
+ }
+ 
+ TEST(AllocTrackerTest, MathLibraryDoesNotAllocate) {
+     double values[64];
+     for (int i = 0; i < 64; i++) values[i] = i;
+ 
+     AllocScope scope;
+     double sum = 0.0, sq = 0.0;
+     Calculator::accumulate(values, 64, sum, sq);
+     sum = Calculator::add(sum, Calculator::mul(2.0, Calculator::power(3.0, 4.0)));
+     sum = Calculator::root(sum, 2.0) + Calculator::fact(6.0) + Calculator::modulo(17.0, 5.0);
+     EXPECT_EQ(0u, scope.delta().count);
+     EXPECT_GT(sum, 0.0);
+ }
+ 
+ TEST(GlyphAtlasTest, ShelfPackingDoesNotOverlap) {
+     GlyphAtlas atlas(64, 64, 1);
+     std::vector<AtlasRect> rects;
+     AtlasRect rect;
+     while (atlas.Pack(10, 6 + rects.size() % 3, rect)) rects.push_back(rect);
+ 
+     ASSERT_FALSE(rects.empty());
+     for (size_t i = 0; i < rects.size(); i++) {
+         EXPECT_GE(rects[i].x, 1);
+         EXPECT_LE(rects[i].x + rects[i].w, 63);
+         EXPECT_LE(rects[i].y + rects[i].h, 63);
+         for (size_t j = i + 1; j < rects.size(); j++) {
+             bool apart = rects[i].x + rects[i].w < rects[j].x || rects[j].x + rects[j].w < rects[i].x
+                       || rects[i].y + rects[i].h < rects[j].y || rects[j].y + rects[j].h < rects[i].y;
+             EXPECT_TRUE(apart) << i << " overlaps " << j;
+         }
+     }
+     EXPECT_FALSE(atlas.Pack(65, 1, rect));
+ }
+ 
+ TEST(GlyphAtlasTest, ClearedShelfIsReused) {
+     GlyphAtlas atlas(32, 16, 1);
+     AtlasRect first, second, rect;
+     ASSERT_TRUE(atlas.Pack(30, 6, first));
+     ASSERT_TRUE(atlas.Pack(30, 6, second));
+     EXPECT_FALSE(atlas.Pack(30, 6, rect));
+ 
+     EXPECT_TRUE(atlas.ShelfFits(first.shelf, 30, 6));
+     EXPECT_FALSE(atlas.ShelfFits(first.shelf, 30, 7));
+     atlas.ClearShelf(first.shelf);
+     ASSERT_TRUE(atlas.Pack(30, 6, rect));
+     EXPECT_EQ(first.shelf, rect.shelf);
+     EXPECT_EQ(first.y, rect.y);
+ }
+ 
+ TEST(InputRecorderTest, ReplayMatchesRecording) {
+     const std::string path = testing::TempDir() + "input_recording.bin";
+     {
+         InputRecorder recorder;
+         ASSERT_TRUE(recorder.StartRecording(path));
+         InputEvent event;
+         event.type = InputEventType::Tick;
+         event.x = 0.016f;
+         recorder.Add(event);
+         event = InputEvent{};
+         event.type = InputEventType::Char;
+         event.code = '7';
+         recorder.Add(event);
+         event = InputEvent{};
+         event.type = InputEventType::Tick;
+         event.time = 0.5f;
+         event.x = 0.02f;
+         recorder.Add(event);
+         EXPECT_EQ(2u, recorder.TickCount());
+     }
+ 
+     InputRecorder replay;
+     ASSERT_TRUE(replay.StartReplay(path));
+     EXPECT_EQ(2u, replay.TickCount());
+     InputEvent frame;
+     ASSERT_TRUE(replay.NextTick(frame));
+     EXPECT_FLOAT_EQ(0.016f, frame.x);
+     const InputEvent* event = replay.NextEvent();
+     ASSERT_NE(nullptr, event);
+     EXPECT_EQ(InputEventType::Char, event->type);
+     EXPECT_EQ('7', event->code);
+     EXPECT_EQ(nullptr, replay.NextEvent());
+     ASSERT_TRUE(replay.NextTick(frame));
+     EXPECT_FLOAT_EQ(0.5f, frame.time);
+     EXPECT_FALSE(replay.NextTick(frame));
+     std::remove(path.c_str());
+ }
+ 
+ TEST(SimulationThreadTest, QueueAndTripleBuffer) {
+     SpscQueue<int, 4> queue;
+     for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.Push(i));
+     EXPECT_FALSE(queue.Push(4));
+     int value = -1;
+     ASSERT_TRUE(queue.Pop(value));
+     EXPECT_EQ(0, value);
+     EXPECT_TRUE(queue.Push(4));
+     for (int i = 1; i <= 4; ++i) {
+         ASSERT_TRUE(queue.Pop(value));
+         EXPECT_EQ(i, value);
+     }
+     EXPECT_TRUE(queue.Empty());
+ 
+     TripleBuffer<int> buffer;
+     EXPECT_FALSE(buffer.Update());
+     buffer.Back() = 1;
+     buffer.Publish();
+     buffer.Back() = 2;
+     buffer.Publish();  // replaces the unread 1
+     EXPECT_TRUE(buffer.Fresh());
+     EXPECT_TRUE(buffer.Update());
+     EXPECT_EQ(2, buffer.Front());
+     EXPECT_FALSE(buffer.Fresh());
+     EXPECT_FALSE(buffer.Update());
+     EXPECT_EQ(2, buffer.Front());
+ }
+ 
+ TEST(MeshOptimizerTest, WeldReorderAndPack) {
+     // 16x16 quad grid as an unshared triangle list
+     const int n = 16;
+     std::vector<float> grid, vertices;
+     std::vector<uint32_t> gridIndices, indices;
+     BuildQuadGrid(n, grid, gridIndices);
+     for (uint32_t i : gridIndices) {
+         indices.push_back(static_cast<uint32_t>(vertices.size() / 3));
+         vertices.insert(vertices.end(), &grid[i * 3], &grid[i * 3 + 3]);
+     }
+     std::vector<float> original = vertices;
+     std::vector<uint32_t> originalIndices = indices;
+ 
+     EXPECT_EQ(static_cast<size_t>((n + 1) * (n + 1)), WeldVertices(vertices, 3, indices));
+     float welded = AverageCacheMissRatio(indices.data(), indices.size());
+     OptimizeVertexCache(indices.data(), indices.size(), vertices.size() / 3);
+     EXPECT_LT(AverageCacheMissRatio(indices.data(), indices.size()), welded);
+     OptimizeVertexFetch(vertices, 3, indices);
+ 
+     // same triangles (as position triples, rotation and order ignored) before and after
+     auto triangles = [](const std::vector<float>& v, const std::vector<uint32_t>& idx) {
+         std::vector<std::array<std::pair<float, float>, 3>> tris;
+         for (size_t i = 0; i < idx.size(); i += 3) {
+             std::array<std::pair<float, float>, 3> tri;
+             for (int k = 0; k < 3; ++k) tri[k] = { v[idx[i + k] * 3], v[idx[i + k] * 3 + 1] };
+             std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end()); // keeps winding
+             tris.push_back(tri);
+         }
+         std::sort(tris.begin(), tris.end());
+         return tris;
+     };
+     EXPECT_EQ(triangles(original, originalIndices), triangles(vertices, indices));
+ 
+     EXPECT_FLOAT_EQ(0.5f, HalfToFloat(FloatToHalf(0.5f)));
+     EXPECT_NEAR(0.1234f, HalfToFloat(FloatToHalf(0.1234f)), 1e-4f);
+     EXPECT_EQ(0x3C00, FloatToHalf(1.0f));
+     EXPECT_EQ(511u | (0u << 10) | (0x201u << 20), PackNormal(1.0f, 0.0f, -1.0f));
+ }
+ 
+ TEST(MeshOptimizerTest, SimplifyKeepsOutlineAndOrientation) {
+     // flat 16x16 quad grid in the unit square, facing +z
+     const int n = 16;
+     std::vector<float> vertices;
+     std::vector<uint32_t> indices;
+     BuildQuadGrid(n, vertices, indices);
+ 
+     std::vector<uint32_t> simplified(indices.size());
+     float error = -1.0f;
+     size_t count = SimplifyMesh(simplified.data(), indices.data(), indices.size(), vertices.data(),
+                                 vertices.size() / 3, 3, 0, 1e-4f, &error);
+     ASSERT_GT(count, 0u);
+     EXPECT_LT(count, indices.size() / 8);  // a plane needs few triangles
+     EXPECT_NEAR(0.0f, error, 1e-4f);
+ 
+     // same area and no flipped triangles, so the square is still covered exactly once
+     double area = 0.0;
+     for (size_t t = 0; t < count; t += 3) {
+         const float* p0 = &vertices[simplified[t] * 3];
+         const float* p1 = &vertices[simplified[t + 1] * 3];
+         const float* p2 = &vertices[simplified[t + 2] * 3];
+         double z = (p1[0] - p0[0]) * (p2[1] - p0[1]) - (p1[1] - p0[1]) * (p2[0] - p0[0]);
+         EXPECT_GT(z, 0.0);
+         area += z * 0.5;
+     }
+     EXPECT_NEAR(1.0, area, 1e-5);
+ 
+     // a bent grid cannot lose its fold within a tiny error
+     for (int y = 0; y <= n; ++y) vertices[(y * (n + 1) + n / 2) * 3 + 2] = 0.25f;
+     count = SimplifyMesh(simplified.data(), indices.data(), indices.size(), vertices.data(),
+                          vertices.size() / 3, 3, 0, 1e-4f, &error);
+     bool fold_kept = false;
+     for (size_t i = 0; i < count; ++i) fold_kept |= vertices[simplified[i] * 3 + 2] == 0.25f;
+     EXPECT_TRUE(fold_kept);
+ }
+ 
+ TEST(MeshCacheTest, WriteAndMap) {
+     std::vector<PackedVertex> vertices(3);
+     for (int i = 0; i < 3; ++i) vertices[i].position[0] = static_cast<float>(i);
+     uint16_t indices[3] = { 0, 1, 2 };
+     MeshRange range;
+     range.indexCount = 3;
+     range.material = 0;
+     MeshMaterial material;
+     std::snprintf(material.name, sizeof(material.name), "Buttons");
+     material.layer = 0;
+ 
+     MeshBuffers buffers;
+     buffers.vertices = vertices.data();
+     buffers.vertexCount = 3;
+     buffers.indices = indices;
+     buffers.indexCount = 3;
+     buffers.indexSize = 2;
+     buffers.ranges = &range;
+     buffers.rangeCount = 1;
+     MeshLod lod;
+     lod.indexCount = 3;
+     buffers.lods = &lod;
+     buffers.lodCount = 1;
+     buffers.materials = &material;
+     buffers.materialCount = 1;
+ 
+     const std::string path = testing::TempDir() + "mesh_cache_test.mesh";
+     ASSERT_TRUE(MeshCache::Write(path, 42, buffers));
+ 
+     MeshCache stale;
+     EXPECT_FALSE(stale.Open(path, 43));
+ 
+     MeshCache cache;
+     ASSERT_TRUE(cache.Open(path, 42));
+     const MeshBuffers& mapped = cache.Buffers();
+     ASSERT_EQ(3u, mapped.vertexCount);
+     EXPECT_FLOAT_EQ(2.0f, mapped.vertices[2].position[0]);
+     ASSERT_EQ(2u, mapped.indexSize);
+     EXPECT_EQ(2, static_cast<const uint16_t*>(mapped.indices)[2]);
+     ASSERT_EQ(1u, mapped.rangeCount);
+     EXPECT_EQ(3u, mapped.ranges[0].indexCount);
+     ASSERT_EQ(1u, mapped.lodCount);
+     EXPECT_EQ(3u, mapped.lods[0].indexCount);
+     ASSERT_EQ(1u, mapped.materialCount);
+     EXPECT_STREQ("Buttons", mapped.materials[0].name);
+ 
+     // right size, but a range past the index buffer
+     range.firstIndex = 1;
+     ASSERT_TRUE(MeshCache::Write(path, 42, buffers));
+     MeshCache corrupt;
+     EXPECT_FALSE(corrupt.Open(path, 42));
+ 
+     // an index past the vertices
+     range.firstIndex = 0;
+     indices[2] = 3;
+     ASSERT_TRUE(MeshCache::Write(path, 42, buffers));
+     MeshCache out_of_range;
+     EXPECT_FALSE(out_of_range.Open(path, 42));
+ 
+     // no LOD to draw
+     indices[2] = 2;
+     buffers.lodCount = 0;
+     ASSERT_TRUE(MeshCache::Write(path, 42, buffers));
+     MeshCache no_lod;
+     EXPECT_FALSE(no_lod.Open(path, 42));
+     std::remove(path.c_str());
+ }
+ 
+ TEST(ObjParserTest, ChunkedParseMatchesSerial) {
+     ObjData small;
+     ASSERT_TRUE(ParseObj("mtllib calc.mtl\nv 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0.5 0.25\nvn 0 0 1\n"
+                          "o Body\nusemtl Plastic\nf 1/1 2/1 3/1 4/1\nusemtl Screen\nf -4//1 -3//1 -2//1\n",
+                          small, 1));
+     ASSERT_EQ(1u, small.materialLibraries.size());
+     ASSERT_EQ(2u, small.shapes.size());
+     EXPECT_EQ("Body", small.shapes[0].name);
+     EXPECT_EQ("Plastic", small.shapes[0].material);
+     EXPECT_EQ(6u, small.shapes[0].indexCount); // quad as a fan of two triangles
+     EXPECT_EQ("Screen", small.shapes[1].material);
+     EXPECT_EQ(6u, small.shapes[1].firstIndex);
+     EXPECT_EQ(0, small.corners[6].vertex);
+     EXPECT_EQ(-1, small.corners[6].texcoord);
+     EXPECT_EQ(0, small.corners[0].texcoord);
+     std::string error;
+     EXPECT_FALSE(ParseObj("v 0 0 0\nf 1 2 3\n", small, 1, &error));
+ 
+     // large enough for many chunks, relative indices and shapes crossing chunk boundaries
+     std::string text;
+     for (int i = 0; i < 40000; ++i) {
+         if (i % 7000 == 0) text += "o Part" + std::to_string(i) + "\n";
+         if (i % 3000 == 0) text += "usemtl Mat" + std::to_string(i % 2) + "\n";
+         text += "v " + std::to_string(i) + " 0.5 -1\nv 1 " + std::to_string(i) + " 0\nv 0 0 1\nvn 0 0 1\n";
+         text += i % 2 ? "f -3//-1 -2//-1 -1//-1\n" : "f " + std::to_string(3 * i + 1) + "//" + std::to_string(i + 1)
+             + " " + std::to_string(3 * i + 2) + "//" + std::to_string(i + 1) + " " + std::to_string(3 * i + 3) + "//"
+             + std::to_string(i + 1) + "\n";
+     }
+     ObjData serial, parallel;
+     ASSERT_TRUE(ParseObj(text, serial, 1));
+     ASSERT_TRUE(ParseObj(text, parallel, 8));
+     EXPECT_EQ(serial.positions, parallel.positions);
+     EXPECT_EQ(serial.normals, parallel.normals);
+     ASSERT_EQ(120000u, parallel.corners.size());
+     for (size_t i = 0; i < parallel.corners.size(); ++i) {
+         ASSERT_EQ(static_cast<int32_t>(i), parallel.corners[i].vertex);
+         ASSERT_EQ(static_cast<int32_t>(i / 3), parallel.corners[i].normal);
+     }
+     ASSERT_EQ(serial.shapes.size(), parallel.shapes.size());
+     for (size_t i = 0; i < serial.shapes.size(); ++i) {
+         EXPECT_EQ(serial.shapes[i].name, parallel.shapes[i].name);
+         EXPECT_EQ(serial.shapes[i].material, parallel.shapes[i].material);
+         EXPECT_EQ(serial.shapes[i].firstIndex, parallel.shapes[i].firstIndex);
+         EXPECT_EQ(serial.shapes[i].indexCount, parallel.shapes[i].indexCount);
+     }
+ }
+ 
+ // Nested jobs, upload tasks in order on the owning thread and progress that never finishes early
+ TEST(JobSystemTest, JobsUploadsAndProgress) {
+     JobSystem jobs(4);
+     UploadQueue uploads;
+     LoadProgress progress;
+     std::atomic<int> decoded = 0;
+     progress.Add(1);
+     jobs.Submit([&] {
+         progress.Add(2 * 16); // announced before the parent step completes
+         progress.Complete();
+         for (int i = 0; i < 16; ++i) {
+             jobs.Submit([&, i] {
+                 ++decoded;
+                 progress.Complete();
+                 uploads.Push([&progress] { progress.Complete(); });
+                 if (i == 0) throw std::runtime_error("bad asset"); // logged, the pool keeps running
+             });
+         }
+     });
+     jobs.Submit([] { throw 1; });
+     jobs.WaitIdle();
+     EXPECT_EQ(16, decoded.load());
+     EXPECT_EQ(33u, progress.Total());
+     EXPECT_EQ(17u, progress.Done());
+     EXPECT_FALSE(progress.Finished());
+ 
+     // a zero budget still runs one task per call
+     EXPECT_EQ(1u, uploads.Run(0.0));
+     EXPECT_EQ(15u, uploads.Pending());
+     EXPECT_EQ(15u, uploads.Run(1000.0));
+     EXPECT_TRUE(progress.Finished());
+     EXPECT_FLOAT_EQ(1.0f, progress.Fraction());
+ 
+     jobs.Stop();
+     jobs.Submit([&] { ++decoded; }); // ignored once stopped
+     EXPECT_EQ(16, decoded.load());
+ }
+ 
  /**
   * @brief Main function to run all tests
   */